@@ -1,5 +1,8 @@
 #include <gbm.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wlr/backend/session.h>
 #include <wlr/util/log.h>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
@@ -13,6 +16,16 @@ struct atomic {
 	bool failed;
 };
 
+static void invalidate_crtc_prop_caches(struct wlr_drm_crtc *crtc) {
+	crtc->prop_cache.len = 0;
+	if (crtc->primary) {
+		crtc->primary->prop_cache.len = 0;
+	}
+	if (crtc->cursor) {
+		crtc->cursor->prop_cache.len = 0;
+	}
+}
+
 static void atomic_begin(struct wlr_drm_crtc *crtc, struct atomic *atom) {
 	if (!crtc->atomic) {
 		crtc->atomic = drmModeAtomicAlloc();
@@ -28,8 +41,11 @@ static void atomic_begin(struct wlr_drm_crtc *crtc, struct atomic *atom) {
 	atom->failed = false;
 }
 
-static bool atomic_end(int drm_fd, struct atomic *atom) {
+static bool atomic_end(int drm_fd, struct wlr_drm_crtc *crtc,
+		struct atomic *atom) {
 	if (atom->failed) {
+		drmModeAtomicSetCursor(atom->req, atom->cursor);
+		invalidate_crtc_prop_caches(crtc);
 		return false;
 	}
 
@@ -37,6 +53,7 @@ static bool atomic_end(int drm_fd, struct atomic *atom) {
 	if (drmModeAtomicCommit(drm_fd, atom->req, flags, NULL)) {
 		wlr_log_errno(WLR_ERROR, "Atomic test failed");
 		drmModeAtomicSetCursor(atom->req, atom->cursor);
+		invalidate_crtc_prop_caches(crtc);
 		return false;
 	}
 
@@ -48,11 +65,18 @@ static bool atomic_commit(int drm_fd, struct atomic *atom,
 	struct wlr_drm_backend *drm =
 		get_drm_backend_from_backend(conn->output.backend);
 	if (atom->failed) {
+		drmModeAtomicSetCursor(atom->req, atom->cursor);
+		conn->prop_cache.len = 0;
+		invalidate_crtc_prop_caches(conn->crtc);
 		return false;
 	}
 
 	int ret = drmModeAtomicCommit(drm_fd, atom->req, flags, drm);
 	if (ret) {
+		// We don't know which properties have been applied anymore
+		conn->prop_cache.len = 0;
+		invalidate_crtc_prop_caches(conn->crtc);
+
 		wlr_log_errno(WLR_ERROR, "%s: Atomic commit failed (%s)",
 			conn->output.name, modeset ? "modeset" : "pageflip");
 
@@ -77,23 +101,122 @@ static inline void atomic_add(struct atomic *atom, uint32_t id, uint32_t prop, u
 	}
 }
 
+/**
+ * Same as atomic_add, but skips the property if the request already sets it to
+ * the same value or if it's already committed.
+ */
+static void atomic_set(struct atomic *atom, struct wlr_drm_prop_cache *cache,
+		uint32_t id, uint32_t prop, uint64_t val) {
+	size_t i = 0;
+	while (i < cache->len && cache->entries[i].prop != prop) {
+		++i;
+	}
+	if (i < cache->len && cache->entries[i].value == val) {
+		return;
+	}
+
+	atomic_add(atom, id, prop, val);
+	if (atom->failed) {
+		return;
+	}
+
+	if (i == cache->len) {
+		if (cache->len == DRM_PROP_CACHE_LEN) {
+			return;
+		}
+		cache->entries[i].prop = prop;
+		++cache->len;
+	}
+	cache->entries[i].value = val;
+}
+
+static struct wlr_drm_connector *get_crtc_connector(
+		struct wlr_drm_backend *drm, struct wlr_drm_crtc *crtc) {
+	struct wlr_drm_connector *conn;
+	wl_list_for_each(conn, &drm->outputs, link) {
+		if (conn->crtc == crtc) {
+			return conn;
+		}
+	}
+	return NULL;
+}
+
+void atomic_crtc_flush_cursor(struct wlr_drm_backend *drm,
+		struct wlr_drm_crtc *crtc) {
+	if (crtc->atomic == NULL || drmModeAtomicGetCursor(crtc->atomic) == 0) {
+		return;
+	}
+	if (crtc->cursor_pending || crtc->pageflip_deferred || crtc->batched ||
+			drm->commit_batch_depth > 0 || !drm->session->active) {
+		return;
+	}
+	struct wlr_drm_connector *conn = get_crtc_connector(drm, crtc);
+	if (conn == NULL || conn->pageflip_pending) {
+		return;
+	}
+
+	// Request an event to know when another commit can be made
+	uint32_t flags = DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK;
+	if (drmModeAtomicCommit(drm->fd, crtc->atomic, flags, drm)) {
+		wlr_log_errno(WLR_DEBUG, "%s: Cursor atomic commit failed",
+			conn->output.name);
+		return;
+	}
+
+	drmModeAtomicSetCursor(crtc->atomic, 0);
+	crtc->cursor_pending = true;
+}
+
+bool atomic_crtc_cursor_done(struct wlr_drm_backend *drm,
+		struct wlr_drm_crtc *crtc) {
+	crtc->cursor_pending = false;
+	if (!crtc->pageflip_deferred) {
+		// Submit the cursor updates staged meanwhile
+		atomic_crtc_flush_cursor(drm, crtc);
+		return true;
+	}
+	crtc->pageflip_deferred = false;
+
+	bool ok = false;
+	struct wlr_drm_connector *conn = get_crtc_connector(drm, crtc);
+	if (conn != NULL) {
+		struct atomic atom = { .req = crtc->atomic };
+		ok = atomic_commit(drm->fd, &atom, conn,
+			DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK, false);
+	}
+
+	// The kernel has its own reference to the fence
+	if (crtc->primary->in_fence_fd >= 0) {
+		close(crtc->primary->in_fence_fd);
+		crtc->primary->in_fence_fd = -1;
+	}
+
+	return ok;
+}
+
 static void set_plane_props(struct atomic *atom, struct wlr_drm_plane *plane,
 		uint32_t crtc_id, uint32_t fb_id, bool set_crtc_xy) {
 	uint32_t id = plane->id;
 	const union wlr_drm_plane_props *props = &plane->props;
+	struct wlr_drm_prop_cache *cache = &plane->prop_cache;
 
 	// The src_* properties are in 16.16 fixed point
-	atomic_add(atom, id, props->src_x, 0);
-	atomic_add(atom, id, props->src_y, 0);
-	atomic_add(atom, id, props->src_w, (uint64_t)plane->surf.width << 16);
-	atomic_add(atom, id, props->src_h, (uint64_t)plane->surf.height << 16);
-	atomic_add(atom, id, props->crtc_w, plane->surf.width);
-	atomic_add(atom, id, props->crtc_h, plane->surf.height);
+	atomic_set(atom, cache, id, props->src_x, 0);
+	atomic_set(atom, cache, id, props->src_y, 0);
+	atomic_set(atom, cache, id, props->src_w, (uint64_t)plane->surf.width << 16);
+	atomic_set(atom, cache, id, props->src_h, (uint64_t)plane->surf.height << 16);
+	atomic_set(atom, cache, id, props->crtc_w, plane->surf.width);
+	atomic_set(atom, cache, id, props->crtc_h, plane->surf.height);
+	// FB_ID is always set: the pageflip event is only sent for CRTCs which
+	// are part of the request
 	atomic_add(atom, id, props->fb_id, fb_id);
-	atomic_add(atom, id, props->crtc_id, crtc_id);
+	atomic_set(atom, cache, id, props->crtc_id, crtc_id);
+	if (plane->in_fence_fd >= 0 && props->in_fence_fd != 0) {
+		atomic_add(atom, id, props->in_fence_fd, plane->in_fence_fd);
+	}
 	if (set_crtc_xy) {
-		atomic_add(atom, id, props->crtc_x, 0);
-		atomic_add(atom, id, props->crtc_y, 0);
+		atomic_set(atom, cache, id, props->crtc_x, 0);
+		atomic_set(atom, cache, id, props->crtc_y, 0);
 	}
 }
 
@@ -101,16 +224,28 @@ static bool atomic_crtc_pageflip(struct wlr_drm_backend *drm,
 		struct wlr_drm_connector *conn,
 		struct wlr_drm_crtc *crtc,
 		uint32_t fb_id, drmModeModeInfo *mode) {
-	if (mode != NULL) {
+	// Re-use the mode blob if the mode hasn't changed
+	if (mode != NULL && (crtc->mode_id == 0 ||
+			memcmp(&crtc->mode_id_info, mode, sizeof(*mode)) != 0)) {
 		if (crtc->mode_id != 0) {
 			drmModeDestroyPropertyBlob(drm->fd, crtc->mode_id);
+			crtc->mode_id = 0;
 		}
 
 		if (drmModeCreatePropertyBlob(drm->fd, mode, sizeof(*mode),
 				&crtc->mode_id)) {
 			wlr_log_errno(WLR_ERROR, "Unable to create property blob");
+			crtc->mode_id = 0;
 			return false;
 		}
+		crtc->mode_id_info = *mode;
+	}
+
+	// Another DRM master may have changed the KMS state since our last
+	// modeset, e.g. while the session was inactive
+	if (mode != NULL) {
+		conn->prop_cache.len = 0;
+		invalidate_crtc_prop_caches(crtc);
 	}
 
 	uint32_t flags = DRM_MODE_PAGE_FLIP_EVENT;
@@ -122,14 +257,50 @@ static bool atomic_crtc_pageflip(struct wlr_drm_backend *drm,
 
 	struct atomic atom;
 	atomic_begin(crtc, &atom);
-	atomic_add(&atom, conn->id, conn->props.crtc_id, crtc->id);
+	atomic_set(&atom, &conn->prop_cache, conn->id, conn->props.crtc_id,
+		crtc->id);
 	if (mode != NULL && conn->props.link_status != 0) {
 		atomic_add(&atom, conn->id, conn->props.link_status,
 			DRM_MODE_LINK_STATUS_GOOD);
 	}
-	atomic_add(&atom, crtc->id, crtc->props.mode_id, crtc->mode_id);
-	atomic_add(&atom, crtc->id, crtc->props.active, 1);
+	atomic_set(&atom, &crtc->prop_cache, crtc->id, crtc->props.mode_id,
+		crtc->mode_id);
+	atomic_set(&atom, &crtc->prop_cache, crtc->id, crtc->props.active, 1);
+	if (crtc->props.vrr_enabled != 0) {
+		atomic_set(&atom, &crtc->prop_cache, crtc->id,
+			crtc->props.vrr_enabled, conn->vrr_enabled);
+	}
 	set_plane_props(&atom, crtc->primary, crtc->id, fb_id, true);
+
+	// A nonblocking commit would fail while a cursor-only commit is in
+	// flight: leave the properties in the request, they'll be submitted in
+	// atomic_crtc_cursor_done
+	if (mode == NULL && crtc->cursor_pending) {
+		if (atom.failed) {
+			drmModeAtomicSetCursor(atom.req, atom.cursor);
+			conn->prop_cache.len = 0;
+			invalidate_crtc_prop_caches(crtc);
+			return false;
+		}
+		crtc->batched = false;
+		crtc->pageflip_deferred = true;
+		return true;
+	}
+
+	// Leave the properties in the request, they'll be submitted along with
+	// the other outputs' in atomic_commit_batch
+	if (mode == NULL && drm->commit_batch_depth > 0) {
+		if (atom.failed) {
+			drmModeAtomicSetCursor(atom.req, atom.cursor);
+			conn->prop_cache.len = 0;
+			invalidate_crtc_prop_caches(crtc);
+			return false;
+		}
+		crtc->batched = true;
+		return true;
+	}
+
+	crtc->batched = false;
 	return atomic_commit(drm->fd, &atom, conn, flags, mode);
 }
 
@@ -142,14 +313,12 @@ static bool atomic_conn_enable(struct wlr_drm_backend *drm,
 
 	struct atomic atom;
 	atomic_begin(crtc, &atom);
-	atomic_add(&atom, crtc->id, crtc->props.active, enable);
-	if (enable) {
-		atomic_add(&atom, conn->id, conn->props.crtc_id, crtc->id);
-		atomic_add(&atom, crtc->id, crtc->props.mode_id, crtc->mode_id);
-	} else {
-		atomic_add(&atom, conn->id, conn->props.crtc_id, 0);
-		atomic_add(&atom, crtc->id, crtc->props.mode_id, 0);
-	}
+	atomic_set(&atom, &crtc->prop_cache, crtc->id, crtc->props.active,
+		enable);
+	atomic_set(&atom, &conn->prop_cache, conn->id, conn->props.crtc_id,
+		enable ? crtc->id : 0);
+	atomic_set(&atom, &crtc->prop_cache, crtc->id, crtc->props.mode_id,
+		enable ? crtc->mode_id : 0);
 	return atomic_commit(drm->fd, &atom, conn, DRM_MODE_ATOMIC_ALLOW_MODESET,
 		true);
 }
@@ -179,10 +348,15 @@ static bool atomic_crtc_set_cursor(struct wlr_drm_backend *drm,
 		set_plane_props(&atom, plane, crtc->id, fb_id, false);
 	} else {
 		atomic_add(&atom, plane->id, plane->props.fb_id, 0);
-		atomic_add(&atom, plane->id, plane->props.crtc_id, 0);
+		atomic_set(&atom, &plane->prop_cache, plane->id,
+			plane->props.crtc_id, 0);
 	}
 
-	return atomic_end(drm->fd, &atom);
+	if (!atomic_end(drm->fd, crtc, &atom)) {
+		return false;
+	}
+	atomic_crtc_flush_cursor(drm, crtc);
+	return true;
 }
 
 bool legacy_crtc_move_cursor(struct wlr_drm_backend *drm,
@@ -203,9 +377,13 @@ static bool atomic_crtc_move_cursor(struct wlr_drm_backend *drm,
 	struct atomic atom;
 
 	atomic_begin(crtc, &atom);
-	atomic_add(&atom, plane->id, plane->props.crtc_x, x);
-	atomic_add(&atom, plane->id, plane->props.crtc_y, y);
-	return atomic_end(drm->fd, &atom);
+	atomic_set(&atom, &plane->prop_cache, plane->id, plane->props.crtc_x, x);
+	atomic_set(&atom, &plane->prop_cache, plane->id, plane->props.crtc_y, y);
+	if (!atomic_end(drm->fd, crtc, &atom)) {
+		return false;
+	}
+	atomic_crtc_flush_cursor(drm, crtc);
+	return true;
 }
 
 static bool atomic_crtc_set_gamma(struct wlr_drm_backend *drm,
@@ -217,6 +395,20 @@ static bool atomic_crtc_set_gamma(struct wlr_drm_backend *drm,
 		return legacy_iface.crtc_set_gamma(drm, crtc, size, r, g, b);
 	}
 
+	// Re-use the gamma blob if the table hasn't changed
+	if (crtc->gamma_lut != 0 && crtc->gamma_table != NULL &&
+			crtc->gamma_table_size == size &&
+			memcmp(crtc->gamma_table, r, size * sizeof(uint16_t)) == 0 &&
+			memcmp(crtc->gamma_table + size, g, size * sizeof(uint16_t)) == 0 &&
+			memcmp(crtc->gamma_table + 2 * size, b,
+				size * sizeof(uint16_t)) == 0) {
+		struct atomic atom;
+		atomic_begin(crtc, &atom);
+		atomic_set(&atom, &crtc->prop_cache, crtc->id, crtc->props.gamma_lut,
+			crtc->gamma_lut);
+		return atomic_end(drm->fd, crtc, &atom);
+	}
+
 	struct drm_color_lut *gamma = malloc(size * sizeof(struct drm_color_lut));
 	if (gamma == NULL) {
 		wlr_log(WLR_ERROR, "Failed to allocate gamma table");
@@ -243,8 +435,9 @@ static bool atomic_crtc_set_gamma(struct wlr_drm_backend *drm,
 
 	struct atomic atom;
 	atomic_begin(crtc, &atom);
-	atomic_add(&atom, crtc->id, crtc->props.gamma_lut, crtc->gamma_lut);
-	return atomic_end(drm->fd, &atom);
+	atomic_set(&atom, &crtc->prop_cache, crtc->id, crtc->props.gamma_lut,
+		crtc->gamma_lut);
+	return atomic_end(drm->fd, crtc, &atom);
 }
 
 static size_t atomic_crtc_get_gamma_size(struct wlr_drm_backend *drm,
@@ -263,6 +456,58 @@ static size_t atomic_crtc_get_gamma_size(struct wlr_drm_backend *drm,
 	return (size_t)gamma_lut_size;
 }
 
+static bool atomic_commit_batch(struct wlr_drm_backend *drm) {
+	drmModeAtomicReq *req = drmModeAtomicAlloc();
+	if (!req) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+	}
+
+	bool ok = req != NULL;
+	size_t n = 0;
+	struct wlr_drm_connector *conn;
+	wl_list_for_each(conn, &drm->outputs, link) {
+		if (!conn->crtc || !conn->crtc->batched) {
+			continue;
+		}
+		if (ok && drmModeAtomicMerge(req, conn->crtc->atomic) < 0) {
+			wlr_log_errno(WLR_ERROR, "Failed to merge atomic requests");
+			ok = false;
+		}
+		++n;
+	}
+
+	uint32_t flags = DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK;
+	if (ok && n > 0 && drmModeAtomicCommit(drm->fd, req, flags, drm)) {
+		wlr_log_errno(WLR_ERROR, "Batched atomic commit of %zu outputs failed",
+			n);
+		ok = false;
+	}
+	drmModeAtomicFree(req);
+
+	bool all_ok = true;
+	wl_list_for_each(conn, &drm->outputs, link) {
+		struct wlr_drm_crtc *crtc = conn->crtc;
+		if (!crtc || !crtc->batched) {
+			continue;
+		}
+
+		if (ok) {
+			drmModeAtomicSetCursor(crtc->atomic, 0);
+			continue;
+		}
+
+		// Fallback to committing outputs one by one, so that a single
+		// misbehaving output doesn't prevent the others from being updated
+		struct atomic atom = { .req = crtc->atomic };
+		if (!atomic_commit(drm->fd, &atom, conn, flags, false)) {
+			conn->pageflip_pending = false;
+			all_ok = false;
+		}
+	}
+
+	return all_ok;
+}
+
 const struct wlr_drm_interface atomic_iface = {
 	.conn_enable = atomic_conn_enable,
 	.crtc_pageflip = atomic_crtc_pageflip,
@@ -270,4 +515,5 @@ const struct wlr_drm_interface atomic_iface = {
 	.crtc_move_cursor = atomic_crtc_move_cursor,
 	.crtc_set_gamma = atomic_crtc_set_gamma,
 	.crtc_get_gamma_size = atomic_crtc_get_gamma_size,
+	.commit_batch = atomic_commit_batch,
 };
@@ -12,6 +12,7 @@
 #include <string.h>
 #include <strings.h>
 #include <time.h>
+#include <unistd.h>
 #include <wayland-server.h>
 #include <wayland-util.h>
 #include <wlr/backend/interface.h>
@@ -26,6 +27,14 @@
 #include "backend/drm/iface.h"
 #include "backend/drm/util.h"
 #include "util/signal.h"
+#include "util/trace.h"
+
+static void trace_pageflip_submit(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector *conn) {
+	if (trace_enabled()) {
+		clock_gettime(drm->clock, &conn->pageflip_submit_time);
+	}
+}
 
 bool check_drm_features(struct wlr_drm_backend *drm) {
 	uint64_t cap;
@@ -75,6 +84,16 @@ bool check_drm_features(struct wlr_drm_backend *drm) {
 	ret = drmGetCap(drm->fd, DRM_CAP_ADDFB2_MODIFIERS, &cap);
 	drm->addfb2_modifiers = ret == 0 && cap == 1;
 
+	// Buffers created with GBM_BO_USE_LINEAR are placed in
+	// NOUVEAU_GEM_DOMAIN_GART. When the bo is attached to the cursor plane it
+	// is moved to NOUVEAU_GEM_DOMAIN_VRAM. However, this does not wait for the
+	// render operations to complete, leaving an empty surface.
+	// See https://bugs.freedesktop.org/show_bug.cgi?id=109631
+	drmVersion *version = drmGetVersion(drm->fd);
+	drm->cursor_needs_finish = version != NULL &&
+		strcmp(version->name, "nouveau") == 0;
+	drmFreeVersion(version);
+
 	return true;
 }
 
@@ -96,6 +115,7 @@ static bool add_plane(struct wlr_drm_backend *drm,
 	p->type = type;
 	p->id = drm_plane->plane_id;
 	p->props = *props;
+	p->in_fence_fd = -1;
 
 	// Choose an RGB format for the plane
 	uint32_t rgb_format = DRM_FORMAT_INVALID;
@@ -328,6 +348,50 @@ static bool drm_connector_attach_render(struct wlr_output *output,
 	return make_drm_surface_current(&conn->crtc->primary->surf, buffer_age);
 }
 
+static struct gbm_bo *get_mgpu_bo_for_plane(struct wlr_drm_backend *drm,
+		struct wlr_drm_plane *plane, struct gbm_bo *bo,
+		pixman_region32_t *damage) {
+	if (plane->mgpu_direct) {
+		struct gbm_bo *imported =
+			import_drm_surface_mgpu(&plane->mgpu_surf, bo);
+		if (imported != NULL && get_fb_for_bo(imported, plane->drm_format,
+				drm->addfb2_modifiers) != 0) {
+			return imported;
+		}
+
+		wlr_log(WLR_INFO, "Failed to scan out multi-GPU buffer directly, "
+			"falling back to copying");
+		plane->mgpu_direct = false;
+		// The multi-GPU surface contents are out of date
+		damage = NULL;
+	}
+
+	return copy_drm_surface_mgpu(&plane->mgpu_surf, bo, damage);
+}
+
+/**
+ * Some drivers advertise linear buffers but still reject the ones imported
+ * from the primary GPU when flipping. Called after such a page-flip failed:
+ * copy the primary GPU's buffer to the multi-GPU surface from now on, and
+ * return the framebuffer to retry with.
+ */
+static uint32_t get_mgpu_copy_fb_for_plane(struct wlr_drm_backend *drm,
+		struct wlr_drm_plane *plane, struct gbm_bo *bo) {
+	assert(drm->parent && plane->mgpu_direct);
+
+	wlr_log(WLR_INFO, "Failed to flip multi-GPU buffer directly, "
+		"falling back to copying");
+	plane->mgpu_direct = false;
+
+	// The multi-GPU surface contents are out of date
+	bo = copy_drm_surface_mgpu(&plane->mgpu_surf, bo, NULL);
+	if (bo == NULL) {
+		wlr_log(WLR_ERROR, "copy_drm_surface_mgpu failed");
+		return 0;
+	}
+	return get_fb_for_bo(bo, plane->drm_format, drm->addfb2_modifiers);
+}
+
 static bool drm_connector_commit(struct wlr_output *output) {
 	struct wlr_drm_connector *conn = get_drm_connector_from_output(output);
 	struct wlr_drm_backend *drm = get_drm_backend_from_backend(output->backend);
@@ -346,7 +410,7 @@ static bool drm_connector_commit(struct wlr_output *output) {
 		damage = &output->pending.damage;
 	}
 
-	struct gbm_bo *bo;
+	struct gbm_bo *bo, *primary_bo = NULL;
 	uint32_t fb_id = 0;
 	assert(output->pending.committed & WLR_OUTPUT_STATE_BUFFER);
 	switch (output->pending.buffer_type) {
@@ -356,11 +420,12 @@ static bool drm_connector_commit(struct wlr_output *output) {
 			wlr_log(WLR_ERROR, "swap_drm_surface_buffers failed");
 			return false;
 		}
+		primary_bo = bo;
 
 		if (drm->parent) {
-			bo = copy_drm_surface_mgpu(&plane->mgpu_surf, bo);
+			bo = get_mgpu_bo_for_plane(drm, plane, bo, damage);
 			if (bo == NULL) {
-				wlr_log(WLR_ERROR, "copy_drm_surface_mgpu failed");
+				wlr_log(WLR_ERROR, "get_mgpu_bo_for_plane failed");
 				return false;
 			}
 		}
@@ -369,6 +434,15 @@ static bool drm_connector_commit(struct wlr_output *output) {
 			wlr_log(WLR_ERROR, "get_fb_for_bo failed");
 			return false;
 		}
+
+		// Let the kernel wait for rendering to complete instead of relying
+		// on implicit synchronization
+		if (drm->iface == &atomic_iface && plane->props.in_fence_fd != 0) {
+			struct wlr_drm_surface *surf =
+				drm->parent && !plane->mgpu_direct ?
+				&plane->mgpu_surf : &plane->surf;
+			plane->in_fence_fd = wlr_egl_dup_fence_fd(&surf->renderer->egl);
+		}
 		break;
 	case WLR_OUTPUT_STATE_BUFFER_SCANOUT:
 		bo = import_gbm_bo(&drm->renderer, &conn->pending_dmabuf);
@@ -385,16 +459,62 @@ static bool drm_connector_commit(struct wlr_output *output) {
 		break;
 	}
 
-	if (conn->pageflip_pending) {
+	bool vrr_enabled = conn->vrr_enabled;
+	if (output->pending.committed & WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED) {
+		if (!output->pending.adaptive_sync_enabled) {
+			conn->vrr_enabled = false;
+		} else if (output->adaptive_sync_supported &&
+				crtc->props.vrr_enabled != 0) {
+			conn->vrr_enabled = true;
+		} else {
+			wlr_log(WLR_DEBUG, "Adaptive sync unsupported on output '%s'",
+				conn->output.name);
+		}
+	}
+
+	bool ok = !conn->pageflip_pending;
+	if (!ok) {
 		wlr_log(WLR_ERROR, "Skipping pageflip on output '%s'", conn->output.name);
-		return false;
+	} else {
+		ok = drm->iface->crtc_pageflip(drm, conn, crtc, fb_id, NULL);
+		if (!ok && drm->parent && plane->mgpu_direct && primary_bo != NULL) {
+			fb_id = get_mgpu_copy_fb_for_plane(drm, plane, primary_bo);
+			if (fb_id != 0) {
+				if (plane->in_fence_fd >= 0) {
+					close(plane->in_fence_fd);
+					plane->in_fence_fd = -1;
+				}
+				if (drm->iface == &atomic_iface &&
+						plane->props.in_fence_fd != 0) {
+					plane->in_fence_fd = wlr_egl_dup_fence_fd(
+						&plane->mgpu_surf.renderer->egl);
+				}
+				ok = drm->iface->crtc_pageflip(drm, conn, crtc, fb_id, NULL);
+			}
+		}
+	}
+
+	// The kernel has its own reference to the fence. Batched and deferred
+	// pageflips haven't been submitted yet, the fence is closed once they are.
+	if (plane->in_fence_fd >= 0 && !crtc->batched &&
+			!crtc->pageflip_deferred) {
+		close(plane->in_fence_fd);
+		plane->in_fence_fd = -1;
 	}
 
-	if (!drm->iface->crtc_pageflip(drm, conn, crtc, fb_id, NULL)) {
+	if (!ok) {
+		conn->vrr_enabled = vrr_enabled;
 		return false;
 	}
 
+	if (output->adaptive_sync_enabled != conn->vrr_enabled) {
+		output->adaptive_sync_enabled = conn->vrr_enabled;
+		wlr_log(WLR_INFO, "Adaptive sync %s on output '%s'",
+			conn->vrr_enabled ? "enabled" : "disabled", conn->output.name);
+	}
+
 	conn->pageflip_pending = true;
+	trace_pageflip_submit(drm, conn);
 	if (output->pending.buffer_type == WLR_OUTPUT_STATE_BUFFER_SCANOUT) {
 		wlr_buffer_unref(conn->pending_buffer);
 		conn->pending_buffer = wlr_buffer_ref(output->pending.buffer);
@@ -512,6 +632,7 @@ static void drm_connector_start_renderer(struct wlr_drm_connector *conn) {
 	struct wlr_drm_mode *mode = (struct wlr_drm_mode *)conn->output.current_mode;
 	if (drm->iface->crtc_pageflip(drm, conn, crtc, fb_id, &mode->drm_mode)) {
 		conn->pageflip_pending = true;
+		trace_pageflip_submit(drm, conn);
 		wlr_output_update_enabled(&conn->output, true);
 	} else {
 		wl_event_source_timer_update(conn->retry_pageflip,
@@ -644,6 +765,46 @@ bool wlr_drm_connector_add_mode(struct wlr_output *output,
 	return true;
 }
 
+static bool drm_connector_commit_cursor(struct wlr_drm_connector *conn) {
+	struct wlr_drm_backend *drm =
+		get_drm_backend_from_backend(conn->output.backend);
+	struct wlr_drm_plane *plane = conn->crtc->cursor;
+
+	struct gbm_bo *bo = NULL;
+	if (plane->cursor_enabled) {
+		bo = drm->parent ? plane->mgpu_surf.back : plane->surf.back;
+	}
+
+	bool ok = drm->iface->crtc_set_cursor(drm, conn->crtc, bo);
+	if (ok) {
+		wlr_output_update_needs_frame(&conn->output);
+	}
+	return ok;
+}
+
+static void cancel_cursor_fence(struct wlr_drm_connector *conn) {
+	if (conn->cursor_fence != NULL) {
+		wl_event_source_remove(conn->cursor_fence);
+		conn->cursor_fence = NULL;
+	}
+}
+
+static int handle_cursor_fence(int fd, uint32_t mask, void *data) {
+	struct wlr_drm_connector *conn = data;
+	struct wlr_drm_backend *drm =
+		get_drm_backend_from_backend(conn->output.backend);
+
+	cancel_cursor_fence(conn);
+
+	if (conn->crtc == NULL || !drm->session->active) {
+		return 0; // will be committed when session is resumed
+	}
+	if (!drm_connector_commit_cursor(conn)) {
+		wlr_log(WLR_ERROR, "%s: Failed to commit cursor", conn->output.name);
+	}
+	return 0;
+}
+
 static bool drm_connector_set_cursor(struct wlr_output *output,
 		struct wlr_texture *texture, int32_t scale,
 		enum wl_output_transform transform,
@@ -664,6 +825,7 @@ static bool drm_connector_set_cursor(struct wlr_output *output,
 			wlr_log_errno(WLR_ERROR, "Allocation failed");
 			return false;
 		}
+		plane->in_fence_fd = -1;
 		crtc->cursor = plane;
 	}
 
@@ -726,6 +888,8 @@ static bool drm_connector_set_cursor(struct wlr_output *output,
 		return true;
 	}
 
+	cancel_cursor_fence(conn);
+
 	plane->cursor_enabled = false;
 	if (texture != NULL) {
 		int width, height;
@@ -764,23 +928,32 @@ static bool drm_connector_set_cursor(struct wlr_output *output,
 
 	struct gbm_bo *bo = plane->cursor_enabled ? plane->surf.back : NULL;
 	if (bo && drm->parent) {
-		bo = copy_drm_surface_mgpu(&plane->mgpu_surf, bo);
+		bo = copy_drm_surface_mgpu(&plane->mgpu_surf, bo, NULL);
 	}
 
 	if (bo) {
-		// workaround for nouveau
-		// Buffers created with GBM_BO_USER_LINEAR are placed in NOUVEAU_GEM_DOMAIN_GART.
-		// When the bo is attached to the cursor plane it is moved to NOUVEAU_GEM_DOMAIN_VRAM.
-		// However, this does not wait for the render operations to complete, leaving an empty surface.
-		// see https://bugs.freedesktop.org/show_bug.cgi?id=109631
-		// The render operations can be waited for using:
-		glFinish();
-	}
-	bool ok = drm->iface->crtc_set_cursor(drm, crtc, bo);
-	if (ok) {
-		wlr_output_update_needs_frame(output);
+		// Don't stall the GPU pipeline: wait for the cursor rendering to
+		// complete asynchronously and commit the cursor plane afterwards
+		struct wlr_drm_surface *surf =
+			drm->parent ? &plane->mgpu_surf : &plane->surf;
+		int fence_fd = wlr_egl_dup_fence_fd(&surf->renderer->egl);
+		if (fence_fd >= 0) {
+			struct wl_event_loop *ev = wl_display_get_event_loop(drm->display);
+			conn->cursor_fence = wl_event_loop_add_fd(ev, fence_fd,
+				WL_EVENT_READABLE, handle_cursor_fence, conn);
+			close(fence_fd);
+			if (conn->cursor_fence != NULL) {
+				return true;
+			}
+			wlr_log(WLR_ERROR, "Failed to wait for cursor fence");
+		}
+
+		if (drm->cursor_needs_finish) {
+			glFinish();
+		}
 	}
-	return ok;
+
+	return drm_connector_commit_cursor(conn);
 }
 
 static bool drm_connector_move_cursor(struct wlr_output *output,
@@ -842,7 +1015,14 @@ static bool drm_connector_schedule_frame(struct wlr_output *output) {
 		return true;
 	}
 	if (drm->parent) {
-		bo = copy_drm_surface_mgpu(&plane->mgpu_surf, bo);
+		// The primary buffer hasn't changed since the last commit
+		pixman_region32_t damage;
+		pixman_region32_init(&damage);
+		bo = get_mgpu_bo_for_plane(drm, plane, bo, &damage);
+		pixman_region32_fini(&damage);
+		if (bo == NULL) {
+			return false;
+		}
 	}
 
 	if (conn->pageflip_pending) {
@@ -852,11 +1032,18 @@ static bool drm_connector_schedule_frame(struct wlr_output *output) {
 	}
 
 	uint32_t fb_id = get_fb_for_bo(bo, plane->drm_format, drm->addfb2_modifiers);
-	if (!drm->iface->crtc_pageflip(drm, conn, crtc, fb_id, NULL)) {
+	bool ok = drm->iface->crtc_pageflip(drm, conn, crtc, fb_id, NULL);
+	if (!ok && drm->parent && plane->mgpu_direct) {
+		fb_id = get_mgpu_copy_fb_for_plane(drm, plane, plane->surf.back);
+		ok = fb_id != 0 &&
+			drm->iface->crtc_pageflip(drm, conn, crtc, fb_id, NULL);
+	}
+	if (!ok) {
 		return false;
 	}
 
 	conn->pageflip_pending = true;
+	trace_pageflip_submit(drm, conn);
 	wlr_output_update_enabled(output, true);
 	return true;
 }
@@ -915,6 +1102,7 @@ static bool drm_connector_attach_buffer(struct wlr_output *output,
 static void drm_connector_destroy(struct wlr_output *output) {
 	struct wlr_drm_connector *conn = get_drm_connector_from_output(output);
 	drm_connector_cleanup(conn);
+	cancel_cursor_fence(conn);
 	drmModeFreeCrtc(conn->old_crtc);
 	wl_event_source_remove(conn->retry_pageflip);
 	wl_list_remove(&conn->link);
@@ -966,6 +1154,8 @@ static void dealloc_crtc(struct wlr_drm_connector *conn) {
 	wlr_log(WLR_DEBUG, "De-allocating CRTC %zu for output '%s'",
 		conn->crtc - drm->crtcs, conn->output.name);
 
+	cancel_cursor_fence(conn);
+
 	set_drm_connector_gamma(&conn->output, 0, NULL, NULL, NULL);
 	finish_drm_surface(&conn->crtc->primary->surf);
 	finish_drm_surface(&conn->crtc->cursor->surf);
@@ -1264,6 +1454,16 @@ void scan_drm_connectors(struct wlr_drm_backend *drm) {
 
 			get_drm_connector_props(drm->fd, wlr_conn->id, &wlr_conn->props);
 
+			uint64_t vrr_capable = 0;
+			if (drm->iface == &atomic_iface &&
+					wlr_conn->props.vrr_capable != 0) {
+				get_drm_prop(drm->fd, wlr_conn->id,
+					wlr_conn->props.vrr_capable, &vrr_capable);
+			}
+			wlr_conn->output.adaptive_sync_supported = vrr_capable != 0;
+			wlr_conn->output.adaptive_sync_enabled = false;
+			wlr_conn->vrr_enabled = false;
+
 			size_t edid_len = 0;
 			uint8_t *edid = get_drm_prop_blob(drm->fd,
 				wlr_conn->id, wlr_conn->props.edid, &edid_len);
@@ -1363,12 +1563,183 @@ static int mhz_to_nsec(int mhz) {
 	return 1000000000000LL / mhz;
 }
 
+void wlr_drm_backend_begin_commit_batch(struct wlr_backend *backend) {
+	struct wlr_drm_backend *drm = get_drm_backend_from_backend(backend);
+	++drm->commit_batch_depth;
+}
+
+static void group_batched_connectors(struct wlr_drm_backend *drm) {
+	struct wlr_drm_connector *conn;
+	wl_list_for_each(conn, &drm->outputs, link) {
+		if (conn->crtc && conn->crtc->batched) {
+			conn->frame_group = 0;
+			conn->frame_ready = false;
+		}
+	}
+
+	wl_list_for_each(conn, &drm->outputs, link) {
+		if (!conn->crtc || !conn->crtc->batched || conn->frame_group != 0) {
+			continue;
+		}
+
+		uint32_t group = ++drm->last_frame_group;
+		if (group == 0) {
+			group = ++drm->last_frame_group;
+		}
+
+		size_t n = 0;
+		struct wlr_drm_connector *other;
+		wl_list_for_each(other, &drm->outputs, link) {
+			if (other->crtc && other->crtc->batched &&
+					other->frame_group == 0 &&
+					other->output.refresh == conn->output.refresh) {
+				other->frame_group = group;
+				++n;
+			}
+		}
+
+		if (n == 1) {
+			// Nothing to synchronize with
+			conn->frame_group = 0;
+		}
+	}
+}
+
+bool wlr_drm_backend_end_commit_batch(struct wlr_backend *backend) {
+	struct wlr_drm_backend *drm = get_drm_backend_from_backend(backend);
+	assert(drm->commit_batch_depth > 0);
+	if (--drm->commit_batch_depth > 0) {
+		return true;
+	}
+
+	group_batched_connectors(drm);
+
+	bool ok = drm->iface->commit_batch(drm);
+
+	struct wlr_drm_connector *conn;
+	wl_list_for_each(conn, &drm->outputs, link) {
+		struct wlr_drm_crtc *crtc = conn->crtc;
+		if (!crtc || !crtc->batched) {
+			continue;
+		}
+		crtc->batched = false;
+
+		// The kernel has its own reference to the fence
+		if (crtc->primary->in_fence_fd >= 0) {
+			close(crtc->primary->in_fence_fd);
+			crtc->primary->in_fence_fd = -1;
+		}
+
+		if (!conn->pageflip_pending) {
+			// The output has already been told its commit succeeded, retry
+			// later so that it doesn't wait forever for a frame event
+			conn->frame_group = 0;
+			wl_event_source_timer_update(conn->retry_pageflip,
+				1000000.0f / conn->output.current_mode->refresh);
+		}
+	}
+
+	return ok;
+}
+
+/**
+ * Send frame events to the outputs of a frame group once all of them have
+ * been flipped. The commits made in response are batched again, so that the
+ * outputs stay in lockstep.
+ */
+static void send_frame_group(struct wlr_drm_backend *drm, uint32_t group) {
+	if (group == 0) {
+		return;
+	}
+
+	struct wlr_drm_connector *conn;
+	wl_list_for_each(conn, &drm->outputs, link) {
+		if (conn->frame_group == group && conn->pageflip_pending) {
+			return;
+		}
+	}
+
+	wlr_drm_backend_begin_commit_batch(&drm->backend);
+
+	struct wlr_drm_connector *tmp;
+	wl_list_for_each_safe(conn, tmp, &drm->outputs, link) {
+		if (conn->frame_group != group) {
+			continue;
+		}
+		conn->frame_group = 0;
+		if (conn->frame_ready) {
+			conn->frame_ready = false;
+			wlr_output_send_frame(&conn->output);
+		}
+	}
+
+	wlr_drm_backend_end_commit_batch(&drm->backend);
+}
+
+static void trace_pageflip_complete(struct wlr_drm_connector *conn,
+		const struct timespec *present_time) {
+	if (!trace_enabled() || conn->pageflip_submit_time.tv_sec == 0) {
+		return;
+	}
+
+	int64_t latency_nsec =
+		(int64_t)(present_time->tv_sec - conn->pageflip_submit_time.tv_sec) *
+		1000000000 + present_time->tv_nsec -
+		conn->pageflip_submit_time.tv_nsec;
+	trace_counter("wlr_drm_pageflip_latency_us", conn->output.name,
+		latency_nsec / 1000);
+
+	// A pageflip submitted during a refresh cycle completes at the next
+	// vblank, any additional refresh cycle means a vblank has been missed.
+	// With adaptive sync, there is no fixed vblank to miss.
+	int refresh_nsec = mhz_to_nsec(conn->output.refresh);
+	if (refresh_nsec > 0 && !conn->vrr_enabled &&
+			latency_nsec > refresh_nsec) {
+		conn->missed_vblanks += latency_nsec / refresh_nsec;
+		trace_counter("wlr_drm_missed_vblanks", conn->output.name,
+			conn->missed_vblanks);
+	}
+	conn->pageflip_submit_time = (struct timespec){0};
+}
+
+static void handle_cursor_commit_done(struct wlr_drm_backend *drm,
+		struct wlr_drm_crtc *crtc) {
+	if (atomic_crtc_cursor_done(drm, crtc)) {
+		return;
+	}
+
+	// The deferred pageflip failed
+	struct wlr_drm_connector *conn;
+	wl_list_for_each(conn, &drm->outputs, link) {
+		if (conn->crtc != crtc || !conn->pageflip_pending) {
+			continue;
+		}
+		conn->pageflip_pending = false;
+		uint32_t frame_group = conn->frame_group;
+		conn->frame_group = 0;
+		wl_event_source_timer_update(conn->retry_pageflip,
+			1000000.0f / conn->output.current_mode->refresh);
+		send_frame_group(drm, frame_group);
+		break;
+	}
+}
+
 static void page_flip_handler(int fd, unsigned seq,
 		unsigned tv_sec, unsigned tv_usec, unsigned crtc_id, void *data) {
 	struct wlr_drm_backend *drm = data;
 	struct wlr_drm_connector *conn = NULL;
 	struct wlr_drm_connector *search;
 
+	// At most one commit is in flight per CRTC, so this event is for the
+	// cursor-only commit if there's one
+	for (size_t i = 0; i < drm->num_crtcs; ++i) {
+		struct wlr_drm_crtc *crtc = &drm->crtcs[i];
+		if (crtc->id == crtc_id && crtc->cursor_pending) {
+			handle_cursor_commit_done(drm, crtc);
+			return;
+		}
+	}
+
 	wl_list_for_each(search, &drm->outputs, link) {
 		if (search->crtc && search->crtc->id == crtc_id) {
 			conn = search;
@@ -1382,12 +1753,16 @@ static void page_flip_handler(int fd, unsigned seq,
 
 	conn->pageflip_pending = false;
 
+	uint32_t frame_group = conn->frame_group;
 	if (conn->state == WLR_DRM_CONN_DISAPPEARED) {
 		wlr_output_destroy(&conn->output);
+		send_frame_group(drm, frame_group);
 		return;
 	}
 
 	if (conn->state != WLR_DRM_CONN_CONNECTED || conn->crtc == NULL) {
+		conn->frame_group = 0;
+		send_frame_group(drm, frame_group);
 		return;
 	}
 
@@ -1412,17 +1787,31 @@ static void page_flip_handler(int fd, unsigned seq,
 		.tv_sec = tv_sec,
 		.tv_nsec = tv_usec * 1000,
 	};
+	trace_pageflip_complete(conn, &present_time);
+
 	struct wlr_output_event_present present_event = {
 		.when = &present_time,
 		.seq = seq,
-		.refresh = mhz_to_nsec(conn->output.refresh),
+		// The next refresh can't be predicted with adaptive sync
+		.refresh = conn->vrr_enabled ? 0 : mhz_to_nsec(conn->output.refresh),
 		.flags = present_flags,
 	};
 	wlr_output_send_present(&conn->output, &present_event);
 
-	if (drm->session->active) {
+	// The connector may be destroyed by frame event listeners
+	struct wlr_drm_crtc *crtc = conn->crtc;
+	if (frame_group != 0) {
+		conn->frame_ready = drm->session->active;
+		send_frame_group(drm, frame_group);
+	} else if (drm->session->active) {
 		wlr_output_send_frame(&conn->output);
 	}
+
+	// If no new frame has been submitted, cursor updates made during the
+	// pageflip are still waiting in the request
+	if (drm->iface == &atomic_iface) {
+		atomic_crtc_flush_cursor(drm, crtc);
+	}
 }
 
 int handle_drm_event(int fd, uint32_t mask, void *data) {
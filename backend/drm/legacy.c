@@ -79,6 +79,11 @@ size_t legacy_crtc_get_gamma_size(struct wlr_drm_backend *drm,
 	return (size_t)crtc->legacy_crtc->gamma_size;
 }
 
+static bool legacy_commit_batch(struct wlr_drm_backend *drm) {
+	// Legacy pageflips are never batched
+	return true;
+}
+
 const struct wlr_drm_interface legacy_iface = {
 	.conn_enable = legacy_conn_enable,
 	.crtc_pageflip = legacy_crtc_pageflip,
@@ -86,4 +91,5 @@ const struct wlr_drm_interface legacy_iface = {
 	.crtc_move_cursor = legacy_crtc_move_cursor,
 	.crtc_set_gamma = legacy_crtc_set_gamma,
 	.crtc_get_gamma_size = legacy_crtc_get_gamma_size,
+	.commit_batch = legacy_commit_batch,
 };
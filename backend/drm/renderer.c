@@ -1,4 +1,4 @@
-#include <assert.h>
+#include <drm_fourcc.h>
 #include <gbm.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -70,6 +70,10 @@ bool init_drm_surface(struct wlr_drm_surface *surf,
 	surf->width = width;
 	surf->height = height;
 
+	for (size_t i = 0; i < DRM_SURFACE_DAMAGE_RING_LEN; ++i) {
+		pixman_region32_clear(&surf->damage_ring[i]);
+	}
+
 	if (surf->gbm) {
 		if (surf->front) {
 			gbm_surface_release_buffer(surf->gbm, surf->front);
@@ -101,6 +105,9 @@ bool init_drm_surface(struct wlr_drm_surface *surf,
 error_gbm:
 	gbm_surface_destroy(surf->gbm);
 error_zero:
+	for (size_t i = 0; i < DRM_SURFACE_DAMAGE_RING_LEN; ++i) {
+		pixman_region32_fini(&surf->damage_ring[i]);
+	}
 	memset(surf, 0, sizeof(*surf));
 	return false;
 }
@@ -122,6 +129,10 @@ void finish_drm_surface(struct wlr_drm_surface *surf) {
 		gbm_surface_destroy(surf->gbm);
 	}
 
+	for (size_t i = 0; i < DRM_SURFACE_DAMAGE_RING_LEN; ++i) {
+		pixman_region32_fini(&surf->damage_ring[i]);
+	}
+
 	memset(surf, 0, sizeof(*surf));
 }
 
@@ -215,16 +226,43 @@ bool export_drm_bo(struct gbm_bo *bo, struct wlr_dmabuf_attributes *attribs) {
 	return true;
 }
 
-static void free_tex(struct gbm_bo *bo, void *data) {
-	struct wlr_texture *tex = data;
-	wlr_texture_destroy(tex);
+struct mgpu_bo {
+	struct wlr_texture *tex;
+	struct gbm_bo *imported; // primary BO imported on the secondary GPU
+};
+
+static void free_mgpu_bo(struct gbm_bo *bo, void *data) {
+	struct mgpu_bo *mgpu = data;
+	wlr_texture_destroy(mgpu->tex);
+	if (mgpu->imported) {
+		gbm_bo_destroy(mgpu->imported);
+	}
+	free(mgpu);
+}
+
+static struct mgpu_bo *get_mgpu_bo(struct gbm_bo *bo) {
+	struct mgpu_bo *mgpu = gbm_bo_get_user_data(bo);
+	if (mgpu) {
+		return mgpu;
+	}
+
+	mgpu = calloc(1, sizeof(*mgpu));
+	if (!mgpu) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	gbm_bo_set_user_data(bo, mgpu, free_mgpu_bo);
+	return mgpu;
 }
 
 static struct wlr_texture *get_tex_for_bo(struct wlr_drm_renderer *renderer,
 		struct gbm_bo *bo) {
-	struct wlr_texture *tex = gbm_bo_get_user_data(bo);
-	if (tex) {
-		return tex;
+	struct mgpu_bo *mgpu = get_mgpu_bo(bo);
+	if (!mgpu) {
+		return NULL;
+	}
+	if (mgpu->tex) {
+		return mgpu->tex;
 	}
 
 	struct wlr_dmabuf_attributes attribs;
@@ -232,31 +270,97 @@ static struct wlr_texture *get_tex_for_bo(struct wlr_drm_renderer *renderer,
 		return NULL;
 	}
 
-	tex = wlr_texture_from_dmabuf(renderer->wlr_rend, &attribs);
-	if (tex) {
-		gbm_bo_set_user_data(bo, tex, free_tex);
-	}
-
-	return tex;
+	// The EGL image holds its own reference to the DMA-BUF
+	mgpu->tex = wlr_texture_from_dmabuf(renderer->wlr_rend, &attribs);
+	wlr_dmabuf_attributes_finish(&attribs);
+	return mgpu->tex;
 }
 
 struct gbm_bo *copy_drm_surface_mgpu(struct wlr_drm_surface *dest,
-		struct gbm_bo *src) {
-	make_drm_surface_current(dest, NULL);
+		struct gbm_bo *src, pixman_region32_t *damage) {
+	int buffer_age = -1;
+	make_drm_surface_current(dest, &buffer_age);
 
 	struct wlr_texture *tex = get_tex_for_bo(dest->renderer, src);
-	assert(tex);
+	if (tex == NULL) {
+		wlr_log(WLR_ERROR, "Failed to import multi-GPU buffer");
+		return NULL;
+	}
+
+	// Only copy the regions which differ between the source buffer and the
+	// destination buffer's previous contents
+	pixman_region32_t copy_damage;
+	pixman_region32_init(&copy_damage);
+	if (damage == NULL || buffer_age <= 0 ||
+			buffer_age - 1 > DRM_SURFACE_DAMAGE_RING_LEN) {
+		pixman_region32_union_rect(&copy_damage, &copy_damage,
+			0, 0, dest->width, dest->height);
+	} else {
+		pixman_region32_copy(&copy_damage, damage);
+		for (int i = 0; i < buffer_age - 1; ++i) {
+			int j = (dest->damage_idx + i) % DRM_SURFACE_DAMAGE_RING_LEN;
+			pixman_region32_union(&copy_damage, &copy_damage,
+				&dest->damage_ring[j]);
+		}
+	}
 
 	float mat[9];
 	wlr_matrix_projection(mat, 1, 1, WL_OUTPUT_TRANSFORM_NORMAL);
 
 	struct wlr_renderer *renderer = dest->renderer->wlr_rend;
 	wlr_renderer_begin(renderer, dest->width, dest->height);
-	wlr_renderer_clear(renderer, (float[]){ 0.0, 0.0, 0.0, 0.0 });
-	wlr_render_texture_with_matrix(renderer, tex, mat, 1.0f);
+
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(&copy_damage, &nrects);
+	for (int i = 0; i < nrects; ++i) {
+		struct wlr_box box = {
+			.x = rects[i].x1,
+			.y = rects[i].y1,
+			.width = rects[i].x2 - rects[i].x1,
+			.height = rects[i].y2 - rects[i].y1,
+		};
+		wlr_renderer_scissor(renderer, &box);
+		wlr_renderer_clear(renderer, (float[]){ 0.0, 0.0, 0.0, 0.0 });
+		wlr_render_texture_with_matrix(renderer, tex, mat, 1.0f);
+	}
+
+	wlr_renderer_scissor(renderer, NULL);
 	wlr_renderer_end(renderer);
 
-	return swap_drm_surface_buffers(dest, NULL);
+	pixman_region32_fini(&copy_damage);
+
+	// Same as decrementing, but works on unsigned integers
+	dest->damage_idx += DRM_SURFACE_DAMAGE_RING_LEN - 1;
+	dest->damage_idx %= DRM_SURFACE_DAMAGE_RING_LEN;
+	pixman_region32_t *prev = &dest->damage_ring[dest->damage_idx];
+	if (damage != NULL) {
+		pixman_region32_copy(prev, damage);
+	} else {
+		pixman_region32_union_rect(prev, prev,
+			0, 0, dest->width, dest->height);
+	}
+
+	return swap_drm_surface_buffers(dest, damage);
+}
+
+struct gbm_bo *import_drm_surface_mgpu(struct wlr_drm_surface *dest,
+		struct gbm_bo *src) {
+	struct mgpu_bo *mgpu = get_mgpu_bo(src);
+	if (!mgpu) {
+		return NULL;
+	}
+	if (mgpu->imported) {
+		return mgpu->imported;
+	}
+
+	struct wlr_dmabuf_attributes attribs;
+	if (!export_drm_bo(src, &attribs)) {
+		return NULL;
+	}
+
+	mgpu->imported = import_gbm_bo(dest->renderer, &attribs);
+	wlr_dmabuf_attributes_finish(&attribs);
+	return mgpu->imported;
 }
 
 bool init_drm_plane_surfaces(struct wlr_drm_plane *plane,
@@ -278,5 +382,10 @@ bool init_drm_plane_surfaces(struct wlr_drm_plane *plane,
 		return false;
 	}
 
+	// If the secondary GPU can scan out linear buffers, try to display the
+	// primary GPU's buffers directly instead of copying them
+	plane->mgpu_direct = wlr_drm_format_set_has(&plane->formats,
+		plane->drm_format, DRM_FORMAT_MOD_LINEAR);
+
 	return true;
 }
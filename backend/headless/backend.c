@@ -1,9 +1,11 @@
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wlr/interfaces/wlr_input_device.h>
 #include <wlr/interfaces/wlr_output.h>
 #include <wlr/render/egl.h>
 #include <wlr/render/gles2.h>
+#include <wlr/render/pixman.h>
 #include <wlr/util/log.h>
 #include "backend/headless.h"
 #include "glapi.h"
@@ -62,7 +64,9 @@ static void backend_destroy(struct wlr_backend *wlr_backend) {
 	wlr_signal_emit_safe(&wlr_backend->events.destroy, backend);
 
 	wlr_renderer_destroy(backend->renderer);
-	wlr_egl_finish(&backend->egl);
+	if (backend->egl.display != NULL) {
+		wlr_egl_finish(&backend->egl);
+	}
 	free(backend);
 }
 
@@ -109,12 +113,17 @@ struct wlr_backend *wlr_headless_backend_create(struct wl_display *display,
 		EGL_NONE,
 	};
 
-	if (!create_renderer_func) {
-		create_renderer_func = wlr_renderer_autocreate;
+	const char *renderer_name = getenv("WLR_RENDERER");
+	if (!create_renderer_func && renderer_name != NULL &&
+			strcmp(renderer_name, "pixman") == 0) {
+		backend->renderer = wlr_pixman_renderer_create();
+	} else {
+		if (!create_renderer_func) {
+			create_renderer_func = wlr_renderer_autocreate;
+		}
+		backend->renderer = create_renderer_func(&backend->egl,
+			EGL_PLATFORM_SURFACELESS_MESA, NULL, (EGLint*)config_attribs, 0);
 	}
-
-	backend->renderer = create_renderer_func(&backend->egl,
-		EGL_PLATFORM_SURFACELESS_MESA, NULL, (EGLint*)config_attribs, 0);
 	if (!backend->renderer) {
 		wlr_log(WLR_ERROR, "Failed to create renderer");
 		free(backend);
@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <wlr/interfaces/wlr_output.h>
+#include <wlr/render/pixman.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/util/log.h>
 #include "backend/headless.h"
@@ -24,21 +25,39 @@ static EGLSurface egl_create_surface(struct wlr_egl *egl, unsigned int width,
 	return surf;
 }
 
+static bool output_create_buffer(struct wlr_headless_output *output,
+		unsigned int width, unsigned int height) {
+	struct wlr_headless_backend *backend = output->backend;
+	if (wlr_renderer_is_pixman(backend->renderer)) {
+		output->image = pixman_image_create_bits(PIXMAN_x8r8g8b8,
+			width, height, NULL, 0);
+		return output->image != NULL;
+	}
+	output->egl_surface = egl_create_surface(&backend->egl, width, height);
+	return output->egl_surface != EGL_NO_SURFACE;
+}
+
+static void output_destroy_buffer(struct wlr_headless_output *output) {
+	if (output->image != NULL) {
+		pixman_image_unref(output->image);
+		output->image = NULL;
+	}
+	wlr_egl_destroy_surface(&output->backend->egl, output->egl_surface);
+	output->egl_surface = EGL_NO_SURFACE;
+}
+
 static bool output_set_custom_mode(struct wlr_output *wlr_output, int32_t width,
 		int32_t height, int32_t refresh) {
 	struct wlr_headless_output *output =
 		headless_output_from_output(wlr_output);
-	struct wlr_headless_backend *backend = output->backend;
 
 	if (refresh <= 0) {
 		refresh = HEADLESS_DEFAULT_REFRESH;
 	}
 
-	wlr_egl_destroy_surface(&backend->egl, output->egl_surface);
-
-	output->egl_surface = egl_create_surface(&backend->egl, width, height);
-	if (output->egl_surface == EGL_NO_SURFACE) {
-		wlr_log(WLR_ERROR, "Failed to recreate EGL surface");
+	output_destroy_buffer(output);
+	if (!output_create_buffer(output, width, height)) {
+		wlr_log(WLR_ERROR, "Failed to recreate output buffer");
 		wlr_output_destroy(wlr_output);
 		return false;
 	}
@@ -53,6 +72,15 @@ static bool output_attach_render(struct wlr_output *wlr_output,
 		int *buffer_age) {
 	struct wlr_headless_output *output =
 		headless_output_from_output(wlr_output);
+	if (output->image != NULL) {
+		wlr_pixman_renderer_bind_image(output->backend->renderer,
+			output->image);
+		// The image keeps the previous frame's contents
+		if (buffer_age != NULL) {
+			*buffer_age = 1;
+		}
+		return true;
+	}
 	return wlr_egl_make_current(&output->backend->egl, output->egl_surface,
 		buffer_age);
 }
@@ -71,7 +99,7 @@ static void output_destroy(struct wlr_output *wlr_output) {
 
 	wl_event_source_remove(output->frame_timer);
 
-	wlr_egl_destroy_surface(&output->backend->egl, output->egl_surface);
+	output_destroy_buffer(output);
 	free(output);
 }
 
@@ -109,9 +137,8 @@ struct wlr_output *wlr_headless_add_output(struct wlr_backend *wlr_backend,
 		backend->display);
 	struct wlr_output *wlr_output = &output->wlr_output;
 
-	output->egl_surface = egl_create_surface(&backend->egl, width, height);
-	if (output->egl_surface == EGL_NO_SURFACE) {
-		wlr_log(WLR_ERROR, "Failed to create EGL surface");
+	if (!output_create_buffer(output, width, height)) {
+		wlr_log(WLR_ERROR, "Failed to create output buffer");
 		goto error;
 	}
 
@@ -121,8 +148,7 @@ struct wlr_output *wlr_headless_add_output(struct wlr_backend *wlr_backend,
 	snprintf(wlr_output->name, sizeof(wlr_output->name), "HEADLESS-%zd",
 		++backend->last_output_num);
 
-	if (!wlr_egl_make_current(&output->backend->egl, output->egl_surface,
-			NULL)) {
+	if (!output_attach_render(wlr_output, NULL)) {
 		goto error;
 	}
 
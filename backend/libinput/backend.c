@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <libinput.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wlr/backend/interface.h>
 #include <wlr/backend/session.h>
 #include <wlr/util/log.h>
@@ -16,11 +17,20 @@ static struct wlr_libinput_backend *get_libinput_backend_from_backend(
 static int libinput_open_restricted(const char *path,
 		int flags, void *_backend) {
 	struct wlr_libinput_backend *backend = _backend;
+	if (backend->input_thread != NULL &&
+			input_thread_is_current(backend->input_thread)) {
+		return input_thread_open_file(backend->input_thread, path);
+	}
 	return wlr_session_open_file(backend->session, path);
 }
 
 static void libinput_close_restricted(int fd, void *_backend) {
 	struct wlr_libinput_backend *backend = _backend;
+	if (backend->input_thread != NULL &&
+			input_thread_is_current(backend->input_thread)) {
+		input_thread_close_file(backend->input_thread, fd);
+		return;
+	}
 	wlr_session_close_file(backend->session, fd);
 }
 
@@ -29,6 +39,14 @@ static const struct libinput_interface libinput_impl = {
 	.close_restricted = libinput_close_restricted
 };
 
+void handle_libinput_events(struct wlr_libinput_backend *backend) {
+	struct libinput_event *event;
+	while ((event = libinput_get_event(backend->libinput_context))) {
+		handle_libinput_event(backend, event);
+		libinput_event_destroy(event);
+	}
+}
+
 static int handle_libinput_readable(int fd, uint32_t mask, void *_backend) {
 	struct wlr_libinput_backend *backend = _backend;
 	if (libinput_dispatch(backend->libinput_context) != 0) {
@@ -36,11 +54,7 @@ static int handle_libinput_readable(int fd, uint32_t mask, void *_backend) {
 		// TODO: some kind of abort?
 		return 0;
 	}
-	struct libinput_event *event;
-	while ((event = libinput_get_event(backend->libinput_context))) {
-		handle_libinput_event(backend, event);
-		libinput_event_destroy(event);
-	}
+	handle_libinput_events(backend);
 	return 0;
 }
 
@@ -87,6 +101,17 @@ static bool backend_start(struct wlr_backend *wlr_backend) {
 		}
 	}
 
+	const char *thread_env = getenv("WLR_LIBINPUT_THREAD");
+	if (thread_env != NULL && strcmp(thread_env, "1") == 0 &&
+			backend->input_thread == NULL) {
+		if (input_thread_create(backend) != NULL) {
+			wlr_log(WLR_DEBUG, "libinput successfully initialized");
+			return true;
+		}
+		wlr_log(WLR_ERROR, "Failed to start libinput thread, "
+			"falling back to the main loop");
+	}
+
 	struct wl_event_loop *event_loop =
 		wl_display_get_event_loop(backend->display);
 	if (backend->input_event) {
@@ -109,6 +134,9 @@ static void backend_destroy(struct wlr_backend *wlr_backend) {
 	struct wlr_libinput_backend *backend =
 		get_libinput_backend_from_backend(wlr_backend);
 
+	input_thread_destroy(backend->input_thread);
+	backend->input_thread = NULL;
+
 	for (size_t i = 0; i < backend->wlr_device_lists.length; i++) {
 		struct wl_list *wlr_devices = backend->wlr_device_lists.items[i];
 		struct wlr_input_device *wlr_dev, *next;
@@ -149,11 +177,13 @@ static void session_signal(struct wl_listener *listener, void *data) {
 		return;
 	}
 
+	input_thread_acquire(backend);
 	if (session->active) {
 		libinput_resume(backend->libinput_context);
 	} else {
 		libinput_suspend(backend->libinput_context);
 	}
+	input_thread_release(backend);
 }
 
 static void handle_display_destroy(struct wl_listener *listener, void *data) {
@@ -199,6 +229,20 @@ struct libinput_device *wlr_libinput_get_device_handle(
 	return dev->handle;
 }
 
+static struct wlr_libinput_backend *get_backend_from_input_device(
+		struct wlr_input_device *wlr_dev) {
+	struct libinput_device *handle = wlr_libinput_get_device_handle(wlr_dev);
+	return libinput_get_user_data(libinput_device_get_context(handle));
+}
+
+void wlr_libinput_device_acquire(struct wlr_input_device *wlr_dev) {
+	input_thread_acquire(get_backend_from_input_device(wlr_dev));
+}
+
+void wlr_libinput_device_release(struct wlr_input_device *wlr_dev) {
+	input_thread_release(get_backend_from_input_device(wlr_dev));
+}
+
 uint32_t usec_to_msec(uint64_t usec) {
 	return (uint32_t)(usec / 1000);
 }
@@ -8,6 +8,7 @@
 #include <wlr/util/log.h>
 #include "backend/libinput.h"
 #include "util/signal.h"
+#include "util/trace.h"
 
 struct wlr_libinput_input_device *get_libinput_device_from_device(
 		struct wlr_input_device *wlr_dev) {
@@ -222,10 +223,38 @@ static void handle_device_removed(struct wlr_libinput_backend *backend,
 	free(wlr_devices);
 }
 
+static void trace_libinput_event(struct libinput_event *event,
+		enum libinput_event_type event_type) {
+	uint64_t time_usec;
+	switch (event_type) {
+	case LIBINPUT_EVENT_KEYBOARD_KEY:
+		time_usec = libinput_event_keyboard_get_time_usec(
+			libinput_event_get_keyboard_event(event));
+		break;
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		time_usec = libinput_event_pointer_get_time_usec(
+			libinput_event_get_pointer_event(event));
+		break;
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+		time_usec = libinput_event_touch_get_time_usec(
+			libinput_event_get_touch_event(event));
+		break;
+	default:
+		return;
+	}
+	trace_input_event(time_usec);
+}
+
 void handle_libinput_event(struct wlr_libinput_backend *backend,
 		struct libinput_event *event) {
 	struct libinput_device *libinput_dev = libinput_event_get_device(event);
 	enum libinput_event_type event_type = libinput_event_get_type(event);
+	trace_libinput_event(event, event_type);
 	switch (event_type) {
 	case LIBINPUT_EVENT_DEVICE_ADDED:
 		handle_device_added(backend, libinput_dev);
@@ -0,0 +1,288 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libinput.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wlr/backend/session.h>
+#include <wlr/util/log.h>
+#include "backend/libinput.h"
+
+static bool set_pipe_flags(int fd) {
+	int flags = fcntl(fd, F_GETFD);
+	if (flags < 0 || fcntl(fd, F_SETFD, flags | FD_CLOEXEC) < 0) {
+		return false;
+	}
+	flags = fcntl(fd, F_GETFL);
+	if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		return false;
+	}
+	return true;
+}
+
+static bool open_pipe(int fds[static 2]) {
+	if (pipe(fds) != 0) {
+		return false;
+	}
+	if (!set_pipe_flags(fds[0]) || !set_pipe_flags(fds[1])) {
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	return true;
+}
+
+static void wake_up(int fd) {
+	// If the pipe is full, the other end will wake up anyway
+	char c = 0;
+	if (write(fd, &c, 1) < 0 && errno != EAGAIN) {
+		wlr_log_errno(WLR_ERROR, "Failed to wake up libinput thread");
+	}
+}
+
+static void drain_pipe(int fd) {
+	char buf[64];
+	while (read(fd, buf, sizeof(buf)) > 0) {
+		// Keep reading
+	}
+}
+
+/**
+ * Run the pending session request, if any. The mutex must be locked.
+ */
+static void handle_request(struct wlr_libinput_input_thread *thread) {
+	if (!thread->request.pending) {
+		return;
+	}
+
+	struct wlr_session *session = thread->backend->session;
+	if (thread->request.path != NULL) {
+		thread->request.fd =
+			wlr_session_open_file(session, thread->request.path);
+	} else {
+		wlr_session_close_file(session, thread->request.fd);
+	}
+
+	thread->request.pending = false;
+	pthread_cond_broadcast(&thread->cond);
+}
+
+static void *input_thread_run(void *data) {
+	struct wlr_libinput_input_thread *thread = data;
+	struct libinput *libinput = thread->backend->libinput_context;
+
+	struct pollfd fds[] = {
+		{ .fd = libinput_get_fd(libinput), .events = POLLIN },
+		{ .fd = thread->stop_fds[0], .events = POLLIN },
+	};
+
+	while (true) {
+		if (poll(fds, sizeof(fds) / sizeof(fds[0]), -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			wlr_log_errno(WLR_ERROR, "poll failed");
+			break;
+		}
+
+		pthread_mutex_lock(&thread->mutex);
+		while (thread->main_depth > 0 && !thread->stopping) {
+			pthread_cond_wait(&thread->cond, &thread->mutex);
+		}
+		if (thread->stopping) {
+			pthread_mutex_unlock(&thread->mutex);
+			break;
+		}
+		thread->dispatching = true;
+		pthread_mutex_unlock(&thread->mutex);
+
+		if (libinput_dispatch(libinput) != 0) {
+			wlr_log(WLR_ERROR, "Failed to dispatch libinput");
+		}
+		bool pending = libinput_next_event_type(libinput) != LIBINPUT_EVENT_NONE;
+
+		pthread_mutex_lock(&thread->mutex);
+		thread->dispatching = false;
+		pthread_cond_broadcast(&thread->cond);
+		pthread_mutex_unlock(&thread->mutex);
+
+		if (pending) {
+			wake_up(thread->notify_fds[1]);
+		}
+	}
+
+	return NULL;
+}
+
+static int handle_notify(int fd, uint32_t mask, void *data) {
+	struct wlr_libinput_input_thread *thread = data;
+	drain_pipe(fd);
+
+	pthread_mutex_lock(&thread->mutex);
+	handle_request(thread);
+	pthread_mutex_unlock(&thread->mutex);
+
+	input_thread_acquire(thread->backend);
+	handle_libinput_events(thread->backend);
+	input_thread_release(thread->backend);
+	return 0;
+}
+
+struct wlr_libinput_input_thread *input_thread_create(
+		struct wlr_libinput_backend *backend) {
+	struct wlr_libinput_input_thread *thread =
+		calloc(1, sizeof(struct wlr_libinput_input_thread));
+	if (thread == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	thread->backend = backend;
+
+	if (!open_pipe(thread->notify_fds)) {
+		wlr_log_errno(WLR_ERROR, "Failed to create pipe");
+		goto error_thread;
+	}
+	if (!open_pipe(thread->stop_fds)) {
+		wlr_log_errno(WLR_ERROR, "Failed to create pipe");
+		goto error_notify;
+	}
+
+	struct wl_event_loop *event_loop =
+		wl_display_get_event_loop(backend->display);
+	thread->notify_source = wl_event_loop_add_fd(event_loop,
+		thread->notify_fds[0], WL_EVENT_READABLE, handle_notify, thread);
+	if (thread->notify_source == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create input event on event loop");
+		goto error_stop;
+	}
+
+	pthread_mutex_init(&thread->mutex, NULL);
+	pthread_cond_init(&thread->cond, NULL);
+
+	// libinput may call open_restricted as soon as the thread is running
+	thread->main_thread = pthread_self();
+	backend->input_thread = thread;
+
+	int ret = pthread_create(&thread->thread, NULL, input_thread_run, thread);
+	if (ret != 0) {
+		wlr_log(WLR_ERROR, "Failed to create libinput thread: %s",
+			strerror(ret));
+		backend->input_thread = NULL;
+		goto error_source;
+	}
+
+	wlr_log(WLR_INFO, "Reading input devices on a dedicated thread");
+	return thread;
+
+error_source:
+	pthread_cond_destroy(&thread->cond);
+	pthread_mutex_destroy(&thread->mutex);
+	wl_event_source_remove(thread->notify_source);
+error_stop:
+	close(thread->stop_fds[0]);
+	close(thread->stop_fds[1]);
+error_notify:
+	close(thread->notify_fds[0]);
+	close(thread->notify_fds[1]);
+error_thread:
+	free(thread);
+	return NULL;
+}
+
+void input_thread_destroy(struct wlr_libinput_input_thread *thread) {
+	if (thread == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&thread->mutex);
+	thread->stopping = true;
+	pthread_cond_broadcast(&thread->cond);
+	// The input thread may be waiting for a session request
+	while (thread->dispatching) {
+		if (thread->request.pending) {
+			handle_request(thread);
+		} else {
+			pthread_cond_wait(&thread->cond, &thread->mutex);
+		}
+	}
+	pthread_mutex_unlock(&thread->mutex);
+
+	wake_up(thread->stop_fds[1]);
+	pthread_join(thread->thread, NULL);
+
+	pthread_cond_destroy(&thread->cond);
+	pthread_mutex_destroy(&thread->mutex);
+	wl_event_source_remove(thread->notify_source);
+	close(thread->stop_fds[0]);
+	close(thread->stop_fds[1]);
+	close(thread->notify_fds[0]);
+	close(thread->notify_fds[1]);
+	free(thread);
+}
+
+bool input_thread_is_current(struct wlr_libinput_input_thread *thread) {
+	return !pthread_equal(pthread_self(), thread->main_thread);
+}
+
+void input_thread_acquire(struct wlr_libinput_backend *backend) {
+	struct wlr_libinput_input_thread *thread = backend->input_thread;
+	if (thread == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&thread->mutex);
+	while (thread->dispatching) {
+		// The input thread may be waiting for us to run a session request
+		if (thread->request.pending) {
+			handle_request(thread);
+		} else {
+			pthread_cond_wait(&thread->cond, &thread->mutex);
+		}
+	}
+	thread->main_depth++;
+	pthread_mutex_unlock(&thread->mutex);
+}
+
+void input_thread_release(struct wlr_libinput_backend *backend) {
+	struct wlr_libinput_input_thread *thread = backend->input_thread;
+	if (thread == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&thread->mutex);
+	assert(thread->main_depth > 0);
+	thread->main_depth--;
+	if (thread->main_depth == 0) {
+		pthread_cond_broadcast(&thread->cond);
+	}
+	pthread_mutex_unlock(&thread->mutex);
+}
+
+static int send_request(struct wlr_libinput_input_thread *thread,
+		const char *path, int fd) {
+	pthread_mutex_lock(&thread->mutex);
+	thread->request.pending = true;
+	thread->request.path = path;
+	thread->request.fd = fd;
+	wake_up(thread->notify_fds[1]);
+	while (thread->request.pending) {
+		pthread_cond_wait(&thread->cond, &thread->mutex);
+	}
+	fd = thread->request.fd;
+	pthread_mutex_unlock(&thread->mutex);
+	return fd;
+}
+
+int input_thread_open_file(struct wlr_libinput_input_thread *thread,
+		const char *path) {
+	return send_request(thread, path, -1);
+}
+
+void input_thread_close_file(struct wlr_libinput_input_thread *thread,
+		int fd) {
+	send_request(thread, NULL, fd);
+}
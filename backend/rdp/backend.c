@@ -4,6 +4,7 @@
 #include <string.h>
 #include <wlr/render/egl.h>
 #include <wlr/render/gles2.h>
+#include <wlr/render/pixman.h>
 #include <wlr/util/log.h>
 #include "backend/rdp.h"
 #include "glapi.h"
@@ -59,7 +60,9 @@ static void backend_destroy(struct wlr_backend *wlr_backend) {
 	wlr_signal_emit_safe(&wlr_backend->events.destroy, backend);
 
 	wlr_renderer_destroy(backend->renderer);
-	wlr_egl_finish(&backend->egl);
+	if (backend->egl.display != NULL) {
+		wlr_egl_finish(&backend->egl);
+	}
 	free(backend->address);
 	free(backend);
 }
@@ -111,12 +114,17 @@ struct wlr_backend *wlr_rdp_backend_create(struct wl_display *display,
 		EGL_NONE,
 	};
 
-	if (!create_renderer_func) {
-		create_renderer_func = wlr_renderer_autocreate;
+	const char *renderer_name = getenv("WLR_RENDERER");
+	if (!create_renderer_func && renderer_name != NULL &&
+			strcmp(renderer_name, "pixman") == 0) {
+		backend->renderer = wlr_pixman_renderer_create();
+	} else {
+		if (!create_renderer_func) {
+			create_renderer_func = wlr_renderer_autocreate;
+		}
+		backend->renderer = create_renderer_func(&backend->egl,
+			EGL_PLATFORM_SURFACELESS_MESA, NULL, (EGLint*)config_attribs, 0);
 	}
-
-	backend->renderer = create_renderer_func(&backend->egl,
-		EGL_PLATFORM_SURFACELESS_MESA, NULL, (EGLint*)config_attribs, 0);
 	if (!backend->renderer) {
 		wlr_log(WLR_ERROR, "Failed to create renderer");
 		free(backend);
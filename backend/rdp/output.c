@@ -6,6 +6,7 @@
 #include <wlr/types/wlr_output.h>
 #include <wlr/interfaces/wlr_output.h>
 #include <wlr/util/log.h>
+#include <wlr/render/pixman.h>
 #include <wlr/render/wlr_renderer.h>
 #include "backend/rdp.h"
 #include "util/signal.h"
@@ -41,13 +42,16 @@ static bool output_set_custom_mode(struct wlr_output *wlr_output, int32_t width,
 		refresh = 60 * 1000; // 60 Hz
 	}
 
-	wlr_egl_destroy_surface(&backend->egl, output->egl_surface);
+	// The pixman renderer draws directly into the shadow surface
+	if (!wlr_renderer_is_pixman(backend->renderer)) {
+		wlr_egl_destroy_surface(&backend->egl, output->egl_surface);
 
-	output->egl_surface = egl_create_surface(&backend->egl, width, height);
-	if (output->egl_surface == EGL_NO_SURFACE) {
-		wlr_log(WLR_ERROR, "Failed to recreate EGL surface");
-		wlr_output_destroy(wlr_output);
-		return false;
+		output->egl_surface = egl_create_surface(&backend->egl, width, height);
+		if (output->egl_surface == EGL_NO_SURFACE) {
+			wlr_log(WLR_ERROR, "Failed to recreate EGL surface");
+			wlr_output_destroy(wlr_output);
+			return false;
+		}
 	}
 
 	output->frame_delay = 1000000 / refresh;
@@ -66,6 +70,15 @@ static bool output_attach_render(struct wlr_output *wlr_output,
 		int *buffer_age) {
 	struct wlr_rdp_output *output =
 		rdp_output_from_output(wlr_output);
+	if (wlr_renderer_is_pixman(output->backend->renderer)) {
+		wlr_pixman_renderer_bind_image(output->backend->renderer,
+			output->shadow_surface);
+		// The shadow surface keeps the previous frame's contents
+		if (buffer_age != NULL) {
+			*buffer_age = 1;
+		}
+		return true;
+	}
 	return wlr_egl_make_current(&output->backend->egl, output->egl_surface,
 		buffer_age);
 }
@@ -186,16 +199,18 @@ static bool output_commit(struct wlr_output *wlr_output) {
 	int width = damage->extents.x2 - damage->extents.x1;
 	int height = damage->extents.y2 - damage->extents.y1;
 
-	// Update shadow buffer
+	// Update shadow buffer, unless it has been rendered to directly
 	struct wlr_renderer *renderer =
 		wlr_backend_get_renderer(&output->backend->backend);
-	// TODO performance: add support for flags
-	ret = wlr_renderer_read_pixels(renderer, WL_SHM_FORMAT_XRGB8888,
-		NULL, pixman_image_get_stride(output->shadow_surface),
-		width, height, x, y, x, y,
-		pixman_image_get_data(output->shadow_surface));
-	if (!ret) {
-		goto out;
+	if (!wlr_renderer_is_pixman(renderer)) {
+		// TODO performance: add support for flags
+		ret = wlr_renderer_read_pixels(renderer, WL_SHM_FORMAT_XRGB8888,
+			NULL, pixman_image_get_stride(output->shadow_surface),
+			width, height, x, y, x, y,
+			pixman_image_get_data(output->shadow_surface));
+		if (!ret) {
+			goto out;
+		}
 	}
 
 	// Send along to clients
@@ -266,20 +281,15 @@ struct wlr_rdp_output *wlr_rdp_output_create(struct wlr_rdp_backend *backend,
 		backend->display);
 	struct wlr_output *wlr_output = &output->wlr_output;
 
-	output->egl_surface = egl_create_surface(&backend->egl, width, height);
-	if (output->egl_surface == EGL_NO_SURFACE) {
-		wlr_log(WLR_ERROR, "Failed to create EGL surface");
-		goto error;
+	if (!output_set_custom_mode(wlr_output, width, height, 0)) {
+		return NULL;
 	}
-
-	output_set_custom_mode(wlr_output, width, height, 0);
 	strncpy(wlr_output->make, "RDP", sizeof(wlr_output->make));
 	strncpy(wlr_output->model, "RDP", sizeof(wlr_output->model));
 	snprintf(wlr_output->name, sizeof(wlr_output->name), "RDP-%d",
 		wl_list_length(&backend->clients));
 
-	if (!wlr_egl_make_current(&output->backend->egl, output->egl_surface,
-			NULL)) {
+	if (!output_attach_render(wlr_output, NULL)) {
 		goto error;
 	}
 
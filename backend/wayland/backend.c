@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <drm_fourcc.h>
 #include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -16,6 +17,7 @@
 
 #include "backend/wayland.h"
 #include "util/signal.h"
+#include "linux-dmabuf-unstable-v1-client-protocol.h"
 #include "xdg-decoration-unstable-v1-client-protocol.h"
 #include "pointer-gestures-unstable-v1-client-protocol.h"
 #include "xdg-shell-client-protocol.h"
@@ -58,6 +60,24 @@ static const struct xdg_wm_base_listener xdg_wm_base_listener = {
 	xdg_wm_base_handle_ping,
 };
 
+static void linux_dmabuf_v1_handle_format(void *data,
+		struct zwp_linux_dmabuf_v1 *linux_dmabuf_v1, uint32_t format) {
+	// Superseded by the modifier event
+}
+
+static void linux_dmabuf_v1_handle_modifier(void *data,
+		struct zwp_linux_dmabuf_v1 *linux_dmabuf_v1, uint32_t format,
+		uint32_t modifier_hi, uint32_t modifier_lo) {
+	struct wlr_wl_backend *wl = data;
+	uint64_t modifier = ((uint64_t)modifier_hi << 32) | modifier_lo;
+	wlr_drm_format_set_add(&wl->linux_dmabuf_v1_formats, format, modifier);
+}
+
+static const struct zwp_linux_dmabuf_v1_listener linux_dmabuf_v1_listener = {
+	.format = linux_dmabuf_v1_handle_format,
+	.modifier = linux_dmabuf_v1_handle_modifier,
+};
+
 static void registry_global(void *data, struct wl_registry *registry,
 		uint32_t name, const char *iface, uint32_t version) {
 	struct wlr_wl_backend *wl = data;
@@ -81,6 +101,12 @@ static void registry_global(void *data, struct wl_registry *registry,
 	} else if (strcmp(iface, zwp_pointer_gestures_v1_interface.name) == 0) {
 		wl->zwp_pointer_gestures_v1 = wl_registry_bind(registry, name,
 			&zwp_pointer_gestures_v1_interface, 1);
+	} else if (strcmp(iface, zwp_linux_dmabuf_v1_interface.name) == 0 &&
+			version >= 3) {
+		wl->zwp_linux_dmabuf_v1 = wl_registry_bind(registry, name,
+			&zwp_linux_dmabuf_v1_interface, 3);
+		zwp_linux_dmabuf_v1_add_listener(wl->zwp_linux_dmabuf_v1,
+			&linux_dmabuf_v1_listener, wl);
 	}
 }
 
@@ -135,6 +161,11 @@ static void backend_destroy(struct wlr_backend *backend) {
 
 	wlr_signal_emit_safe(&wl->backend.events.destroy, &wl->backend);
 
+	struct wlr_wl_buffer *buffer, *tmp_buffer;
+	wl_list_for_each_safe(buffer, tmp_buffer, &wl->buffers, link) {
+		destroy_wl_buffer(buffer);
+	}
+
 	wl_list_remove(&wl->local_display_destroy.link);
 
 	free(wl->seat_name);
@@ -156,6 +187,10 @@ static void backend_destroy(struct wlr_backend *backend) {
 	if (wl->zwp_pointer_gestures_v1) {
 		zwp_pointer_gestures_v1_destroy(wl->zwp_pointer_gestures_v1);
 	}
+	if (wl->zwp_linux_dmabuf_v1) {
+		zwp_linux_dmabuf_v1_destroy(wl->zwp_linux_dmabuf_v1);
+	}
+	wlr_drm_format_set_finish(&wl->linux_dmabuf_v1_formats);
 	xdg_wm_base_destroy(wl->xdg_wm_base);
 	wl_compositor_destroy(wl->compositor);
 	wl_registry_destroy(wl->registry);
@@ -199,6 +234,7 @@ struct wlr_backend *wlr_wl_backend_create(struct wl_display *display,
 	wl->local_display = display;
 	wl_list_init(&wl->devices);
 	wl_list_init(&wl->outputs);
+	wl_list_init(&wl->buffers);
 
 	wl->remote_display = wl_display_connect(remote);
 	if (!wl->remote_display) {
@@ -273,6 +309,10 @@ error_registry:
 	if (wl->xdg_wm_base) {
 		xdg_wm_base_destroy(wl->xdg_wm_base);
 	}
+	if (wl->zwp_linux_dmabuf_v1) {
+		zwp_linux_dmabuf_v1_destroy(wl->zwp_linux_dmabuf_v1);
+	}
+	wlr_drm_format_set_finish(&wl->linux_dmabuf_v1_formats);
 	wl_registry_destroy(wl->registry);
 error_display:
 	wl_display_disconnect(wl->remote_display);
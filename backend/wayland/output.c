@@ -11,11 +11,13 @@
 
 #include <wlr/interfaces/wlr_output.h>
 #include <wlr/render/wlr_renderer.h>
+#include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_matrix.h>
 #include <wlr/util/log.h>
 
 #include "backend/wayland.h"
 #include "util/signal.h"
+#include "linux-dmabuf-unstable-v1-client-protocol.h"
 #include "xdg-decoration-unstable-v1-client-protocol.h"
 #include "xdg-shell-client-protocol.h"
 
@@ -51,6 +53,101 @@ static bool output_set_custom_mode(struct wlr_output *wlr_output,
 	return true;
 }
 
+void destroy_wl_buffer(struct wlr_wl_buffer *buffer) {
+	if (buffer == NULL) {
+		return;
+	}
+	wl_list_remove(&buffer->buffer_destroy.link);
+	wl_list_remove(&buffer->link);
+	wl_buffer_destroy(buffer->wl_buffer);
+	if (!buffer->released) {
+		wlr_buffer_unref(buffer->buffer);
+	}
+	free(buffer);
+}
+
+static void buffer_handle_release(void *data, struct wl_buffer *wl_buffer) {
+	struct wlr_wl_buffer *buffer = data;
+	buffer->released = true;
+	// May destroy the buffer
+	wlr_buffer_unref(buffer->buffer);
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+	.release = buffer_handle_release,
+};
+
+static void buffer_handle_buffer_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_wl_buffer *buffer =
+		wl_container_of(listener, buffer, buffer_destroy);
+	destroy_wl_buffer(buffer);
+}
+
+static struct wl_buffer *import_dmabuf(struct wlr_wl_backend *wl,
+		struct wlr_dmabuf_attributes *dmabuf) {
+	uint32_t modifier_hi = dmabuf->modifier >> 32;
+	uint32_t modifier_lo = (uint32_t)dmabuf->modifier;
+	struct zwp_linux_buffer_params_v1 *params =
+		zwp_linux_dmabuf_v1_create_params(wl->zwp_linux_dmabuf_v1);
+	for (int i = 0; i < dmabuf->n_planes; i++) {
+		zwp_linux_buffer_params_v1_add(params, dmabuf->fd[i], i,
+			dmabuf->offset[i], dmabuf->stride[i], modifier_hi, modifier_lo);
+	}
+
+	uint32_t flags = 0;
+	if (dmabuf->flags & WLR_DMABUF_ATTRIBUTES_FLAGS_Y_INVERT) {
+		flags |= ZWP_LINUX_BUFFER_PARAMS_V1_FLAGS_Y_INVERT;
+	}
+	if (dmabuf->flags & WLR_DMABUF_ATTRIBUTES_FLAGS_INTERLACED) {
+		flags |= ZWP_LINUX_BUFFER_PARAMS_V1_FLAGS_INTERLACED;
+	}
+	if (dmabuf->flags & WLR_DMABUF_ATTRIBUTES_FLAGS_BOTTOM_FIRST) {
+		flags |= ZWP_LINUX_BUFFER_PARAMS_V1_FLAGS_BOTTOM_FIRST;
+	}
+
+	// The file descriptors are duplicated when the request is sent
+	struct wl_buffer *wl_buffer = zwp_linux_buffer_params_v1_create_immed(
+		params, dmabuf->width, dmabuf->height, dmabuf->format, flags);
+	zwp_linux_buffer_params_v1_destroy(params);
+	return wl_buffer;
+}
+
+static struct wlr_wl_buffer *get_or_create_wl_buffer(
+		struct wlr_wl_backend *wl, struct wlr_buffer *wlr_buffer) {
+	struct wlr_wl_buffer *buffer;
+	wl_list_for_each(buffer, &wl->buffers, link) {
+		if (buffer->buffer == wlr_buffer) {
+			return buffer;
+		}
+	}
+
+	struct wlr_dmabuf_attributes attribs;
+	if (!wlr_buffer_get_dmabuf(wlr_buffer, &attribs)) {
+		return NULL;
+	}
+
+	buffer = calloc(1, sizeof(struct wlr_wl_buffer));
+	if (buffer == NULL) {
+		return NULL;
+	}
+
+	buffer->wl_buffer = import_dmabuf(wl, &attribs);
+	if (buffer->wl_buffer == NULL) {
+		free(buffer);
+		return NULL;
+	}
+	buffer->buffer = wlr_buffer;
+	buffer->released = true;
+	wl_buffer_add_listener(buffer->wl_buffer, &buffer_listener, buffer);
+
+	buffer->buffer_destroy.notify = buffer_handle_buffer_destroy;
+	wl_signal_add(&wlr_buffer->events.destroy, &buffer->buffer_destroy);
+
+	wl_list_insert(&wl->buffers, &buffer->link);
+	return buffer;
+}
+
 static bool output_attach_render(struct wlr_output *wlr_output,
 		int *buffer_age) {
 	struct wlr_wl_output *output =
@@ -59,6 +156,36 @@ static bool output_attach_render(struct wlr_output *wlr_output,
 		buffer_age);
 }
 
+static bool output_attach_buffer(struct wlr_output *wlr_output,
+		struct wlr_buffer *wlr_buffer) {
+	struct wlr_wl_output *output =
+		get_wl_output_from_output(wlr_output);
+	struct wlr_wl_backend *wl = output->backend;
+
+	if (wl->zwp_linux_dmabuf_v1 == NULL) {
+		return false;
+	}
+
+	// Client wl_shm buffers can't be forwarded: their file descriptor isn't
+	// exposed by libwayland-server
+	struct wlr_dmabuf_attributes attribs;
+	if (!wlr_buffer_get_dmabuf(wlr_buffer, &attribs)) {
+		return false;
+	}
+
+	if (attribs.width != wlr_output->width ||
+			attribs.height != wlr_output->height) {
+		return false;
+	}
+
+	if (!wlr_drm_format_set_has(&wl->linux_dmabuf_v1_formats,
+			attribs.format, attribs.modifier)) {
+		return false;
+	}
+
+	return get_or_create_wl_buffer(wl, wlr_buffer) != NULL;
+}
+
 static bool output_commit(struct wlr_output *wlr_output) {
 	struct wlr_wl_output *output =
 		get_wl_output_from_output(wlr_output);
@@ -76,13 +203,51 @@ static bool output_commit(struct wlr_output *wlr_output) {
 		damage = &wlr_output->pending.damage;
 	}
 
-	if (!wlr_egl_swap_buffers(&output->backend->egl,
-			output->egl_surface, damage)) {
-		return false;
+	struct wlr_output_event_present present_event = {0};
+
+	switch (wlr_output->pending.buffer_type) {
+	case WLR_OUTPUT_STATE_BUFFER_RENDER:
+		if (!wlr_egl_swap_buffers(&output->backend->egl,
+				output->egl_surface, damage)) {
+			return false;
+		}
+		break;
+	case WLR_OUTPUT_STATE_BUFFER_SCANOUT:;
+		struct wlr_wl_buffer *buffer = get_or_create_wl_buffer(
+			output->backend, wlr_output->pending.buffer);
+		if (buffer == NULL) {
+			return false;
+		}
+
+		// Keep the client buffer alive until the remote compositor releases
+		// it. If it's still in use, it'll only be released once.
+		if (buffer->released) {
+			buffer->released = false;
+			wlr_buffer_ref(buffer->buffer);
+		}
+		wl_surface_attach(output->surface, buffer->wl_buffer, 0, 0);
+
+		if (damage == NULL) {
+			wl_surface_damage_buffer(output->surface,
+				0, 0, INT32_MAX, INT32_MAX);
+		} else {
+			int rects_len;
+			pixman_box32_t *rects =
+				pixman_region32_rectangles(damage, &rects_len);
+			for (int i = 0; i < rects_len; i++) {
+				pixman_box32_t *r = &rects[i];
+				wl_surface_damage_buffer(output->surface, r->x1, r->y1,
+					r->x2 - r->x1, r->y2 - r->y1);
+			}
+		}
+		wl_surface_commit(output->surface);
+
+		present_event.flags |= WLR_OUTPUT_PRESENT_ZERO_COPY;
+		break;
 	}
 
 	// TODO: if available, use the presentation-time protocol
-	wlr_output_send_present(wlr_output, NULL);
+	wlr_output_send_present(wlr_output, &present_event);
 	return true;
 }
 
@@ -222,6 +387,7 @@ static const struct wlr_output_impl output_impl = {
 	.set_custom_mode = output_set_custom_mode,
 	.destroy = output_destroy,
 	.attach_render = output_attach_render,
+	.attach_buffer = output_attach_buffer,
 	.commit = output_commit,
 	.set_cursor = output_set_cursor,
 	.move_cursor = output_move_cursor,
@@ -0,0 +1,98 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "util/pixel.h"
+
+/**
+ * Measures the red/blue channel swap used when reading back pixels, for each
+ * implementation available on this CPU. The results are checked against the
+ * scalar implementation.
+ *
+ * Usage: pixel-bench [width height [frames]]
+ */
+
+static const struct {
+	enum pixel_impl impl;
+	const char *name;
+} impls[] = {
+	{ PIXEL_IMPL_SCALAR, "scalar" },
+	{ PIXEL_IMPL_SSE2, "sse2" },
+	{ PIXEL_IMPL_AVX2, "avx2" },
+	{ PIXEL_IMPL_NEON, "neon" },
+};
+
+static int64_t timespec_to_nsec(const struct timespec *t) {
+	return (int64_t)t->tv_sec * 1000000000 + t->tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+	size_t width = 1920, height = 1080;
+	long frames = 200;
+	if (argc != 1 && argc != 3 && argc != 4) {
+		fprintf(stderr, "usage: %s [width height [frames]]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (argc >= 3) {
+		width = strtoul(argv[1], NULL, 10);
+		height = strtoul(argv[2], NULL, 10);
+	}
+	if (argc == 4) {
+		frames = strtol(argv[3], NULL, 10);
+	}
+	if (width == 0 || height == 0 || frames <= 0) {
+		fprintf(stderr, "usage: %s [width height [frames]]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	size_t n = width * height;
+	uint32_t *src = malloc(n * sizeof(uint32_t));
+	uint32_t *dst = malloc(n * sizeof(uint32_t));
+	uint32_t *ref = malloc(n * sizeof(uint32_t));
+	if (src == NULL || dst == NULL || ref == NULL) {
+		fprintf(stderr, "Allocation failed\n");
+		return EXIT_FAILURE;
+	}
+	for (size_t i = 0; i < n; ++i) {
+		src[i] = (uint32_t)i * 2654435761u;
+	}
+	pixel_get_swap_rb_row_impl(PIXEL_IMPL_SCALAR)(ref, src, n);
+
+	printf("%zux%zu, %ld frames\n", width, height, frames);
+	printf("%-8s %12s %12s\n", "impl", "ms/frame", "GB/s");
+	for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); ++i) {
+		pixel_swap_rb_row_func_t swap_rb_row =
+			pixel_get_swap_rb_row_impl(impls[i].impl);
+		if (swap_rb_row == NULL) {
+			continue;
+		}
+
+		// Rows are swapped one by one, like pixel_copy_rect_swap_rb does
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (long f = 0; f < frames; ++f) {
+			for (size_t y = 0; y < height; ++y) {
+				swap_rb_row(&dst[y * width], &src[y * width], width);
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		if (memcmp(dst, ref, n * sizeof(uint32_t)) != 0) {
+			fprintf(stderr, "%s: wrong result\n", impls[i].name);
+			return EXIT_FAILURE;
+		}
+
+		double ns = (double)(timespec_to_nsec(&end) -
+			timespec_to_nsec(&start)) / frames;
+		// Each pixel is read and written once
+		double gbps = 2.0 * n * sizeof(uint32_t) / ns;
+		printf("%-8s %12.3f %12.2f\n", impls[i].name, ns / 1000000, gbps);
+	}
+
+	free(src);
+	free(dst);
+	free(ref);
+	return EXIT_SUCCESS;
+}
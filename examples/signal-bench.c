@@ -0,0 +1,84 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <wayland-server.h>
+#include "util/signal.h"
+
+/**
+ * Measures the speedup of wlr_signal_emit_safe, which skips the cursor and
+ * end markers for signals with zero or one listener, over the marker-based
+ * wlr_signal_emit_safe_slow used for every emission before.
+ *
+ * Usage: signal-bench [iterations]
+ */
+
+#define MAX_LISTENERS 8
+
+static volatile uint64_t notify_count = 0;
+
+static void handle_notify(struct wl_listener *listener, void *data) {
+	notify_count++;
+}
+
+static int64_t timespec_to_nsec(const struct timespec *t) {
+	return (int64_t)t->tv_sec * 1000000000 + t->tv_nsec;
+}
+
+static double bench(struct wl_signal *signal, bool fast, long iterations) {
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (fast) {
+		for (long i = 0; i < iterations; ++i) {
+			wlr_signal_emit_safe(signal, NULL);
+		}
+	} else {
+		for (long i = 0; i < iterations; ++i) {
+			wlr_signal_emit_safe_slow(signal, NULL);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (double)(timespec_to_nsec(&end) - timespec_to_nsec(&start)) /
+		iterations;
+}
+
+int main(int argc, char *argv[]) {
+	long iterations = 10000000;
+	if (argc > 1) {
+		iterations = strtol(argv[1], NULL, 10);
+		if (iterations <= 0) {
+			fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	const int listener_counts[] = { 0, 1, 2, MAX_LISTENERS };
+	struct wl_listener listeners[MAX_LISTENERS];
+
+	printf("%-10s %12s %12s %10s\n", "listeners", "slow (ns)", "safe (ns)",
+		"speedup");
+	for (size_t i = 0; i < sizeof(listener_counts) / sizeof(listener_counts[0]);
+			++i) {
+		int n = listener_counts[i];
+
+		struct wl_signal signal;
+		wl_signal_init(&signal);
+		for (int j = 0; j < n; ++j) {
+			listeners[j].notify = handle_notify;
+			wl_signal_add(&signal, &listeners[j]);
+		}
+
+		double slow_ns = bench(&signal, false, iterations);
+		double fast_ns = bench(&signal, true, iterations);
+		printf("%-10d %12.2f %12.2f %9.2fx\n", n, slow_ns, fast_ns,
+			slow_ns / fast_ns);
+
+		for (int j = 0; j < n; ++j) {
+			wl_list_remove(&listeners[j].link);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -18,22 +18,45 @@
 #include "properties.h"
 #include "renderer.h"
 
+#define DRM_PROP_CACHE_LEN 16
+
+/**
+ * Values of the KMS properties of an object as they'll be once the pending
+ * atomic request is committed. Used to skip properties which haven't changed.
+ * Atomic modesetting only.
+ */
+struct wlr_drm_prop_cache {
+	size_t len;
+	struct {
+		uint32_t prop;
+		uint64_t value;
+	} entries[DRM_PROP_CACHE_LEN];
+};
+
 struct wlr_drm_plane {
 	uint32_t type;
 	uint32_t id;
 
 	struct wlr_drm_surface surf;
 	struct wlr_drm_surface mgpu_surf;
+	// Scan out the primary GPU's linear buffers directly instead of copying
+	// them to mgpu_surf
+	bool mgpu_direct;
 
 	uint32_t drm_format; // ARGB8888 or XRGB8888
 	struct wlr_drm_format_set formats;
 
+	// Fence signalled when rendering to the next buffer is done, -1 if none.
+	// Only used by the atomic interface.
+	int in_fence_fd;
+
 	// Only used by cursor
 	float matrix[9];
 	bool cursor_enabled;
 	int32_t cursor_hotspot_x, cursor_hotspot_y;
 
 	union wlr_drm_plane_props props;
+	struct wlr_drm_prop_cache prop_cache;
 };
 
 struct wlr_drm_crtc {
@@ -41,8 +64,17 @@ struct wlr_drm_crtc {
 
 	// Atomic modesetting only
 	uint32_t mode_id;
+	drmModeModeInfo mode_id_info; // contents of the mode_id blob
 	uint32_t gamma_lut;
 	drmModeAtomicReq *atomic;
+	// A pageflip is waiting in the atomic request for the batch to be
+	// committed
+	bool batched;
+	// A cursor-only commit is in flight
+	bool cursor_pending;
+	// A pageflip is waiting in the atomic request for the cursor-only commit
+	// to complete
+	bool pageflip_deferred;
 
 	// Legacy only
 	drmModeCrtc *legacy_crtc;
@@ -58,6 +90,7 @@ struct wlr_drm_crtc {
 	uint32_t *overlays;
 
 	union wlr_drm_crtc_props props;
+	struct wlr_drm_prop_cache prop_cache;
 
 	struct wl_list connectors;
 
@@ -72,9 +105,16 @@ struct wlr_drm_backend {
 	const struct wlr_drm_interface *iface;
 	clockid_t clock;
 	bool addfb2_modifiers;
+	// The driver doesn't wait for rendering to complete before scanning out
+	// a new cursor buffer (nouveau)
+	bool cursor_needs_finish;
 
 	int fd;
 
+	// Pageflips are batched into a single atomic commit while non-zero
+	size_t commit_batch_depth;
+	uint32_t last_frame_group;
+
 	size_t num_crtcs;
 	struct wlr_drm_crtc *crtcs;
 
@@ -119,16 +159,32 @@ struct wlr_drm_connector {
 	uint32_t possible_crtc;
 
 	union wlr_drm_connector_props props;
+	struct wlr_drm_prop_cache prop_cache;
 
 	uint32_t width, height;
 	int32_t cursor_x, cursor_y;
 
+	// Fence of the cursor rendering, the cursor is committed once it signals
+	struct wl_event_source *cursor_fence;
+
 	drmModeCrtc *old_crtc;
 
 	bool pageflip_pending;
+	// Adaptive sync state of the last pageflip, atomic modesetting only
+	bool vrr_enabled;
 	struct wl_event_source *retry_pageflip;
+
+	// Only updated when tracing is enabled
+	struct timespec pageflip_submit_time;
+	int64_t missed_vblanks;
 	struct wl_list link;
 
+	// Outputs flipped in the same batch with the same refresh rate share a
+	// frame group, 0 if none. Their frame events are sent together once all
+	// of them have been flipped.
+	uint32_t frame_group;
+	bool frame_ready;
+
 	// DMA-BUF to be displayed on next commit
 	struct wlr_dmabuf_attributes pending_dmabuf;
 	// Buffer submitted to the kernel but not yet displayed
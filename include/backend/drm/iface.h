@@ -33,9 +33,26 @@ struct wlr_drm_interface {
 	// Get the gamma lut size of a crtc
 	size_t (*crtc_get_gamma_size)(struct wlr_drm_backend *drm,
 		struct wlr_drm_crtc *crtc);
+	// Submit the pageflips of all batched crtcs
+	bool (*commit_batch)(struct wlr_drm_backend *drm);
 };
 
 extern const struct wlr_drm_interface atomic_iface;
 extern const struct wlr_drm_interface legacy_iface;
 
+/**
+ * Submit the properties staged in the request right away if the CRTC is idle,
+ * so that cursor updates don't wait for the next pageflip. Only one commit can
+ * be in flight for a CRTC: the properties are otherwise left in the request,
+ * to be submitted with the next pageflip.
+ */
+void atomic_crtc_flush_cursor(struct wlr_drm_backend *drm,
+	struct wlr_drm_crtc *crtc);
+/**
+ * Handle the completion of a cursor-only atomic commit. Submits the pageflip
+ * deferred meanwhile, if any. Returns false if it fails.
+ */
+bool atomic_crtc_cursor_done(struct wlr_drm_backend *drm,
+	struct wlr_drm_crtc *crtc);
+
 #endif
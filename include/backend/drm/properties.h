@@ -16,12 +16,13 @@ union wlr_drm_connector_props {
 		uint32_t dpms;
 		uint32_t link_status; // not guaranteed to exist
 		uint32_t path;
+		uint32_t vrr_capable; // not guaranteed to exist
 
 		// atomic-modesetting only
 
 		uint32_t crtc_id;
 	};
-	uint32_t props[4];
+	uint32_t props[6];
 };
 
 union wlr_drm_crtc_props {
@@ -36,8 +37,9 @@ union wlr_drm_crtc_props {
 		uint32_t mode_id;
 		uint32_t gamma_lut;
 		uint32_t gamma_lut_size;
+		uint32_t vrr_enabled; // not guaranteed to exist
 	};
-	uint32_t props[6];
+	uint32_t props[7];
 };
 
 union wlr_drm_plane_props {
@@ -58,8 +60,9 @@ union wlr_drm_plane_props {
 		uint32_t crtc_h;
 		uint32_t fb_id;
 		uint32_t crtc_id;
+		uint32_t in_fence_fd; // Not guaranteed to exist
 	};
-	uint32_t props[13];
+	uint32_t props[14];
 };
 
 bool get_drm_connector_props(int fd, uint32_t id,
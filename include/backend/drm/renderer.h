@@ -3,11 +3,14 @@
 
 #include <EGL/egl.h>
 #include <gbm.h>
+#include <pixman.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <wlr/backend.h>
 #include <wlr/render/wlr_renderer.h>
 
+#define DRM_SURFACE_DAMAGE_RING_LEN 2
+
 struct wlr_drm_backend;
 struct wlr_drm_plane;
 
@@ -32,6 +35,11 @@ struct wlr_drm_surface {
 
 	struct gbm_bo *front;
 	struct gbm_bo *back;
+
+	// Circular queue of the damage of previously swapped buffers, used to
+	// only copy damaged regions to multi-GPU surfaces
+	pixman_region32_t damage_ring[DRM_SURFACE_DAMAGE_RING_LEN];
+	size_t damage_idx;
 };
 
 bool init_drm_renderer(struct wlr_drm_backend *drm,
@@ -53,6 +61,8 @@ struct gbm_bo *swap_drm_surface_buffers(struct wlr_drm_surface *surf,
 struct gbm_bo *get_drm_surface_front(struct wlr_drm_surface *surf);
 void post_drm_surface(struct wlr_drm_surface *surf);
 struct gbm_bo *copy_drm_surface_mgpu(struct wlr_drm_surface *dest,
+	struct gbm_bo *src, pixman_region32_t *damage);
+struct gbm_bo *import_drm_surface_mgpu(struct wlr_drm_surface *dest,
 	struct gbm_bo *src);
 struct gbm_bo *import_gbm_bo(struct wlr_drm_renderer *renderer,
 	struct wlr_dmabuf_attributes *attribs);
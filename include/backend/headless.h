@@ -1,6 +1,7 @@
 #ifndef BACKEND_HEADLESS_H
 #define BACKEND_HEADLESS_H
 
+#include <pixman.h>
 #include <wlr/backend/headless.h>
 #include <wlr/backend/interface.h>
 
@@ -25,6 +26,7 @@ struct wlr_headless_output {
 	struct wl_list link;
 
 	void *egl_surface;
+	pixman_image_t *image; // with the pixman renderer, instead of egl_surface
 	struct wl_event_source *frame_timer;
 	int frame_delay; // ms
 };
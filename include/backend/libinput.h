@@ -2,6 +2,8 @@
 #define BACKEND_LIBINPUT_H
 
 #include <libinput.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <wayland-server-core.h>
 #include <wlr/backend/interface.h>
 #include <wlr/backend/libinput.h>
@@ -9,6 +11,36 @@
 #include <wlr/types/wlr_input_device.h>
 #include <wlr/types/wlr_list.h>
 
+/**
+ * A thread reading input devices, enabled with WLR_LIBINPUT_THREAD=1. It keeps
+ * draining the kernel event queues into libinput while the main loop is busy.
+ * Events are still processed on the main loop.
+ *
+ * libinput isn't thread-safe, so it's only used by one thread at a time.
+ * Session requests made by libinput on the input thread (opening and closing
+ * devices) are forwarded to the main loop.
+ */
+struct wlr_libinput_input_thread {
+	struct wlr_libinput_backend *backend;
+	pthread_t thread, main_thread;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	// All fields below are protected by the mutex
+	bool dispatching; // the input thread is using libinput
+	int main_depth; // the main loop is using libinput if > 0
+	bool stopping;
+	struct {
+		bool pending;
+		const char *path; // if NULL, close fd
+		int fd;
+	} request;
+
+	int notify_fds[2]; // wakes up the main loop
+	int stop_fds[2]; // wakes up the input thread
+	struct wl_event_source *notify_source;
+};
+
 struct wlr_libinput_backend {
 	struct wlr_backend backend;
 
@@ -22,6 +54,8 @@ struct wlr_libinput_backend {
 	struct wl_listener session_signal;
 
 	struct wlr_list wlr_device_lists; // list of struct wl_list
+
+	struct wlr_libinput_input_thread *input_thread; // NULL if disabled
 };
 
 struct wlr_libinput_input_device {
@@ -32,6 +66,30 @@ struct wlr_libinput_input_device {
 
 uint32_t usec_to_msec(uint64_t usec);
 
+void handle_libinput_events(struct wlr_libinput_backend *backend);
+
+/**
+ * Start reading input devices on a dedicated thread. Sets the backend's
+ * input_thread on success.
+ */
+struct wlr_libinput_input_thread *input_thread_create(
+	struct wlr_libinput_backend *backend);
+void input_thread_destroy(struct wlr_libinput_input_thread *thread);
+bool input_thread_is_current(struct wlr_libinput_input_thread *thread);
+/**
+ * Take libinput from the input thread, if any. Can be nested. Must be called
+ * on the main loop.
+ */
+void input_thread_acquire(struct wlr_libinput_backend *backend);
+void input_thread_release(struct wlr_libinput_backend *backend);
+/**
+ * Run a session request on the main loop, blocking the input thread.
+ */
+int input_thread_open_file(struct wlr_libinput_input_thread *thread,
+	const char *path);
+void input_thread_close_file(struct wlr_libinput_input_thread *thread,
+	int fd);
+
 void handle_libinput_event(struct wlr_libinput_backend *state,
 		struct libinput_event *event);
 
@@ -9,6 +9,7 @@
 #include <wayland-util.h>
 
 #include <wlr/backend/wayland.h>
+#include <wlr/render/drm_format_set.h>
 #include <wlr/render/egl.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/types/wlr_box.h>
@@ -34,6 +35,9 @@ struct wlr_wl_backend {
 	struct xdg_wm_base *xdg_wm_base;
 	struct zxdg_decoration_manager_v1 *zxdg_decoration_manager_v1;
 	struct zwp_pointer_gestures_v1 *zwp_pointer_gestures_v1;
+	struct zwp_linux_dmabuf_v1 *zwp_linux_dmabuf_v1;
+	struct wlr_drm_format_set linux_dmabuf_v1_formats;
+	struct wl_list buffers; // wlr_wl_buffer.link
 	struct wl_seat *seat;
 	struct wl_pointer *pointer;
 	struct wl_keyboard *keyboard;
@@ -41,6 +45,21 @@ struct wlr_wl_backend {
 	char *seat_name;
 };
 
+/**
+ * A client buffer forwarded to the remote compositor. The wl_buffer is kept
+ * until the client buffer is destroyed, so that it can be attached again
+ * without importing it again. A reference to the client buffer is held while
+ * the remote compositor uses it.
+ */
+struct wlr_wl_buffer {
+	struct wlr_buffer *buffer;
+	struct wl_buffer *wl_buffer;
+	bool released;
+	struct wl_list link; // wlr_wl_backend.buffers
+
+	struct wl_listener buffer_destroy;
+};
+
 struct wlr_wl_output {
 	struct wlr_output wlr_output;
 
@@ -92,6 +111,7 @@ void update_wl_output_cursor(struct wlr_wl_output *output);
 struct wlr_wl_pointer *pointer_get_wl(struct wlr_pointer *wlr_pointer);
 void create_wl_pointer(struct wl_pointer *wl_pointer, struct wlr_wl_output *output);
 void create_wl_keyboard(struct wl_keyboard *wl_keyboard, struct wlr_wl_backend *wl);
+void destroy_wl_buffer(struct wlr_wl_buffer *buffer);
 
 extern const struct wl_seat_listener seat_listener;
 
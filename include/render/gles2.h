@@ -58,6 +58,16 @@ struct wlr_gles2_renderer {
 	} shaders;
 
 	uint32_t viewport_width, viewport_height;
+	size_t draw_calls; // since the last begin, for tracing
+
+	// Buffer bound with wlr_renderer_bind_buffer, read from instead of the
+	// current EGL surface. fbo is zero if unset.
+	struct {
+		EGLImageKHR image;
+		GLuint tex, fbo;
+		uint32_t height;
+		bool inverted_y;
+	} bound_buffer;
 };
 
 enum wlr_gles2_texture_type {
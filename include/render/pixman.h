@@ -0,0 +1,64 @@
+#ifndef RENDER_PIXMAN_H
+#define RENDER_PIXMAN_H
+
+#include <pixman.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <wayland-server.h>
+#include <wlr/render/interface.h>
+#include <wlr/render/pixman.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/render/wlr_texture.h>
+
+struct wlr_pixman_pixel_format {
+	enum wl_shm_format wl_format;
+	pixman_format_code_t pixman_format;
+	int bpp;
+	bool has_alpha;
+};
+
+struct wlr_pixman_renderer {
+	struct wlr_renderer wlr_renderer;
+
+	pixman_image_t *image; // bound with wlr_pixman_renderer_bind_image
+	// Bound with wlr_renderer_bind_buffer, read from instead of image
+	struct wlr_buffer *read_buffer;
+
+	int width, height; // since the last begin
+};
+
+struct wlr_pixman_texture {
+	struct wlr_texture wlr_texture;
+
+	const struct wlr_pixman_pixel_format *format;
+	int width, height;
+	bool writable; // created from pixels
+	pixman_image_t *image; // NULL if the texture is unusable
+
+	// Set if the texture wraps the memory of a wl_shm buffer. The pool can
+	// be remapped by the client, so the image is updated before being used.
+	struct wl_shm_buffer *shm_buffer;
+	struct wl_listener buffer_destroy;
+	void *data; // owned copy of the pixels, if any
+};
+
+const struct wlr_pixman_pixel_format *get_pixman_format_from_wl(
+	enum wl_shm_format fmt);
+const struct wlr_pixman_pixel_format *get_pixman_format_from_pixman(
+	pixman_format_code_t fmt);
+const enum wl_shm_format *get_pixman_wl_formats(size_t *len);
+
+struct wlr_pixman_texture *pixman_get_texture(
+	struct wlr_texture *wlr_texture);
+struct wlr_texture *pixman_texture_from_pixels(enum wl_shm_format wl_fmt,
+	uint32_t stride, uint32_t width, uint32_t height, const void *data);
+struct wlr_texture *pixman_texture_from_wl_shm(struct wl_resource *resource);
+/**
+ * Prepares the texture's image to be sampled. Must be followed by a call to
+ * pixman_texture_end_access.
+ */
+pixman_image_t *pixman_texture_begin_access(
+	struct wlr_pixman_texture *texture);
+void pixman_texture_end_access(struct wlr_pixman_texture *texture);
+
+#endif
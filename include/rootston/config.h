@@ -19,6 +19,7 @@ struct roots_output_config {
 	enum wl_output_transform transform;
 	int x, y;
 	float scale;
+	bool adaptive_sync;
 	struct wl_list link;
 	struct {
 		int width, height;
@@ -42,6 +43,9 @@ struct roots_binding_config {
 	size_t keysyms_len;
 	char *command;
 	struct wl_list link;
+
+	uint32_t hash;
+	struct roots_binding_config *next; // in the same binding_table bucket
 };
 
 struct roots_keyboard_config {
@@ -81,6 +85,9 @@ struct roots_config {
 	struct wl_list outputs;
 	struct wl_list devices;
 	struct wl_list bindings;
+	// Bindings hashed by modifiers and keysyms, built once the config is loaded
+	struct roots_binding_config **binding_table;
+	size_t binding_table_len; // power of two
 	struct wl_list keyboards;
 	struct wl_list cursors;
 	struct wl_list switches;
@@ -130,4 +137,20 @@ struct roots_keyboard_config *roots_config_get_keyboard(
 struct roots_cursor_config *roots_config_get_cursor(struct roots_config *config,
 	const char *seat_name);
 
+/**
+ * Hash a keysym for binding lookups. The hash of a set of keysyms is the sum of
+ * the hashes of its keysyms, so that it doesn't depend on their order and can
+ * be updated incrementally.
+ */
+uint32_t roots_binding_keysym_hash(xkb_keysym_t keysym);
+
+/**
+ * Get the binding triggered by the modifiers and the set of pressed keysyms.
+ * keysyms_hash is the hash of the set. If there's no such binding, returns
+ * NULL.
+ */
+struct roots_binding_config *roots_config_get_binding(
+	struct roots_config *config, uint32_t modifiers,
+	const xkb_keysym_t *keysyms, size_t keysyms_len, uint32_t keysyms_hash);
+
 #endif
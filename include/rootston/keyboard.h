@@ -6,6 +6,12 @@
 
 #define ROOTS_KEYBOARD_PRESSED_KEYSYMS_CAP 32
 
+struct roots_pressed_keysyms {
+	xkb_keysym_t keysyms[ROOTS_KEYBOARD_PRESSED_KEYSYMS_CAP];
+	size_t len;
+	uint32_t hash; // see roots_binding_keysym_hash
+};
+
 struct roots_keyboard {
 	struct roots_input *input;
 	struct roots_seat *seat;
@@ -17,8 +23,8 @@ struct roots_keyboard {
 	struct wl_listener keyboard_key;
 	struct wl_listener keyboard_modifiers;
 
-	xkb_keysym_t pressed_keysyms_translated[ROOTS_KEYBOARD_PRESSED_KEYSYMS_CAP];
-	xkb_keysym_t pressed_keysyms_raw[ROOTS_KEYBOARD_PRESSED_KEYSYMS_CAP];
+	struct roots_pressed_keysyms pressed_keysyms_translated;
+	struct roots_pressed_keysyms pressed_keysyms_raw;
 };
 
 struct roots_keyboard *roots_keyboard_create(struct wlr_input_device *device,
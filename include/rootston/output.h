@@ -19,13 +19,15 @@ struct roots_output {
 	struct timespec last_frame;
 	struct wlr_output_damage *damage;
 
+	struct timespec last_occluded_frame_done;
+	struct wl_event_source *frame_done_timer;
+
 	struct wlr_box usable_area;
 
 	struct wl_listener destroy;
 	struct wl_listener enable;
 	struct wl_listener mode;
 	struct wl_listener transform;
-	struct wl_listener present;
 	struct wl_listener damage_frame;
 	struct wl_listener damage_destroy;
 };
@@ -70,8 +72,12 @@ struct roots_drag_icon;
 void output_damage_whole(struct roots_output *output);
 void output_damage_whole_view(struct roots_output *output,
 	struct roots_view *view);
-void output_damage_from_view(struct roots_output *output,
-	struct roots_view *view);
+/**
+ * Damage a surface of a view and its sub-surfaces. (sx, sy) is the position
+ * of the surface relative to the view.
+ */
+void output_damage_from_view_surface(struct roots_output *output,
+	struct roots_view *view, struct wlr_surface *surface, int sx, int sy);
 void output_damage_whole_drag_icon(struct roots_output *output,
 	struct roots_drag_icon *icon);
 void output_damage_from_local_surface(struct roots_output *output,
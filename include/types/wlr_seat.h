@@ -8,6 +8,13 @@ const struct wlr_pointer_grab_interface default_pointer_grab_impl;
 const struct wlr_keyboard_grab_interface default_keyboard_grab_impl;
 const struct wlr_touch_grab_interface default_touch_grab_impl;
 
+/**
+ * Account for an input event sent to the client. All of its arguments are
+ * expected to be 32 bits wide.
+ */
+void seat_client_count_event(struct wlr_seat_client *seat_client,
+	size_t n_args);
+
 void seat_client_create_pointer(struct wlr_seat_client *seat_client,
 	uint32_t version, uint32_t id);
 void seat_client_destroy_pointer(struct wl_resource *resource);
@@ -19,5 +26,6 @@ void seat_client_destroy_keyboard(struct wl_resource *resource);
 void seat_client_create_touch(struct wlr_seat_client *seat_client,
 	uint32_t version, uint32_t id);
 void seat_client_destroy_touch(struct wl_resource *resource);
+void seat_client_cancel_touch_frame(struct wlr_seat_client *seat_client);
 
 #endif
@@ -0,0 +1,46 @@
+#ifndef UTIL_PIXEL_H
+#define UTIL_PIXEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Copy a rectangle of height rows of row_bytes bytes. If flip_y is set, the
+ * first source row is written to the last destination row.
+ */
+void pixel_copy_rect(void *dst, size_t dst_stride, const void *src,
+	size_t src_stride, size_t row_bytes, size_t height, bool flip_y);
+
+/**
+ * Swap the first and third bytes of n 32-bit pixels, e.g. to convert between
+ * ARGB8888 and ABGR8888 or between XRGB8888 and XBGR8888. dst and src can be
+ * the same buffer.
+ */
+void pixel_swap_rb_row(uint32_t *dst, const uint32_t *src, size_t n);
+
+typedef void (*pixel_swap_rb_row_func_t)(uint32_t *dst, const uint32_t *src,
+	size_t n);
+
+enum pixel_impl {
+	PIXEL_IMPL_SCALAR,
+	PIXEL_IMPL_SSE2,
+	PIXEL_IMPL_AVX2,
+	PIXEL_IMPL_NEON,
+};
+
+/**
+ * Get a specific implementation of pixel_swap_rb_row, or NULL if it isn't
+ * built in or isn't supported by the CPU. pixel_swap_rb_row picks the best
+ * one automatically, this is meant for benchmarks.
+ */
+pixel_swap_rb_row_func_t pixel_get_swap_rb_row_impl(enum pixel_impl impl);
+
+/**
+ * Same as pixel_copy_rect, additionally swapping the red and blue channels of
+ * 32-bit pixels.
+ */
+void pixel_copy_rect_swap_rb(void *dst, size_t dst_stride, const void *src,
+	size_t src_stride, size_t width, size_t height, bool flip_y);
+
+#endif
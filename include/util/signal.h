@@ -3,6 +3,29 @@
 
 #include <wayland-server.h>
 
-void wlr_signal_emit_safe(struct wl_signal *signal, void *data);
+void wlr_signal_emit_safe_slow(struct wl_signal *signal, void *data);
+
+/**
+ * Emit a signal, allowing listeners to remove any listener (including
+ * themselves) and to add new listeners, which won't be notified for this
+ * emission.
+ *
+ * Most signals have zero or one listener, these don't need the markers used
+ * by the general case.
+ */
+static inline void wlr_signal_emit_safe(struct wl_signal *signal, void *data) {
+	struct wl_list *head = &signal->listener_list;
+	if (head->next == head) {
+		return;
+	}
+	if (head->next->next == head) {
+		// The signal may be destroyed by the listener, don't touch it
+		// afterwards
+		struct wl_listener *l = wl_container_of(head->next, l, link);
+		l->notify(l, data);
+		return;
+	}
+	wlr_signal_emit_safe_slow(signal, data);
+}
 
 #endif
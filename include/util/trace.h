@@ -0,0 +1,94 @@
+#ifndef UTIL_TRACE_H
+#define UTIL_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <wayland-server.h>
+#include <wlr/config.h>
+
+struct wlr_output;
+
+/*
+ * Tracepoints and counters, enabled at runtime with WLR_TRACE=1. They are
+ * written to the ftrace marker in the systrace format, so that they can be
+ * recorded with perfetto or trace-cmd alongside kernel events.
+ *
+ * When disabled at runtime, a tracepoint costs a single branch. When disabled
+ * at build time, tracepoints compile to nothing.
+ */
+
+#if WLR_HAS_TRACING
+
+extern int trace_state; // -1 if not initialized yet, 0 if disabled
+
+bool trace_init(void);
+void trace_write_begin(const char *name);
+void trace_write_end(void);
+void trace_write_counter(const char *name, const char *instance,
+	int64_t value);
+
+#define trace_enabled() \
+	(trace_state > 0 || (trace_state < 0 && trace_init()))
+/**
+ * Begin a slice. Slices can be nested, and must be ended in the same
+ * function.
+ */
+#define trace_begin(name) \
+	do { if (trace_enabled()) { trace_write_begin(name); } } while (0)
+#define trace_end() \
+	do { if (trace_enabled()) { trace_write_end(); } } while (0)
+/**
+ * Set the value of a counter. The instance is appended to the counter name if
+ * not NULL, e.g. to have one counter per output.
+ */
+#define trace_counter(name, instance, value) \
+	do { \
+		if (trace_enabled()) { \
+			trace_write_counter(name, instance, value); \
+		} \
+	} while (0)
+
+#else
+
+#define trace_enabled() false
+#define trace_begin(name) do {} while (0)
+#define trace_end() do {} while (0)
+#define trace_counter(name, instance, value) do {} while (0)
+
+#endif
+
+/*
+ * Input-to-photon latency tracing, enabled with WLR_TRACE_INPUT_LATENCY=1.
+ *
+ * One input event is followed at a time: the first event received while no
+ * other is in flight is tagged with its kernel timestamp, then each stage it
+ * goes through is timestamped. Once the frame containing its effects has been
+ * presented, a latency breakdown is written as an ftrace marker.
+ */
+
+/**
+ * An input event has been read from the kernel. time_usec is the kernel
+ * timestamp of the event, in the CLOCK_MONOTONIC domain.
+ */
+void trace_input_event(uint64_t time_usec);
+/**
+ * The input event has been sent to a client, or handled by the compositor if
+ * client is NULL.
+ */
+void trace_seat_notify(struct wl_client *client);
+/**
+ * A client committed a surface.
+ */
+void trace_surface_commit(struct wl_client *client);
+/**
+ * A new frame has been committed on the output.
+ */
+void trace_output_commit(struct wlr_output *output);
+/**
+ * A frame has been presented on the output. when can be NULL if unknown.
+ */
+void trace_output_present(struct wlr_output *output,
+	const struct timespec *when);
+
+#endif
@@ -34,4 +34,25 @@ bool wlr_output_is_drm(struct wlr_output *output);
 typedef struct _drmModeModeInfo drmModeModeInfo;
 bool wlr_drm_connector_add_mode(struct wlr_output *output, const drmModeModeInfo *mode);
 
+/**
+ * Start batching output commits. Until wlr_drm_backend_end_commit_batch is
+ * called, the pageflips of the outputs committed on this backend are
+ * accumulated and submitted in a single atomic request, so that they are
+ * presented in lockstep. Calls can be nested.
+ *
+ * Outputs flipped in the same batch which share a refresh rate get their
+ * frame events sent together, and the commits made in response are batched
+ * automatically.
+ *
+ * Batching is only supported with atomic modesetting, outputs are committed
+ * immediately otherwise.
+ */
+void wlr_drm_backend_begin_commit_batch(struct wlr_backend *backend);
+/**
+ * Submit the pageflips accumulated since wlr_drm_backend_begin_commit_batch.
+ * If the batched commit fails, outputs are committed one by one. Returns
+ * false if some of them couldn't be committed.
+ */
+bool wlr_drm_backend_end_commit_batch(struct wlr_backend *backend);
+
 #endif
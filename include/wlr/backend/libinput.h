@@ -17,9 +17,22 @@
 
 struct wlr_backend *wlr_libinput_backend_create(struct wl_display *display,
 		struct wlr_session *session);
-/** Gets the underlying libinput_device handle for the given wlr_input_device */
+/**
+ * Gets the underlying libinput_device handle for the given wlr_input_device.
+ *
+ * If libinput is dispatched on a dedicated thread (WLR_LIBINPUT_THREAD=1),
+ * the handle must only be used in input device signal handlers, or between
+ * wlr_libinput_device_acquire and wlr_libinput_device_release.
+ */
 struct libinput_device *wlr_libinput_get_device_handle(
 		struct wlr_input_device *dev);
+/**
+ * Prevents the libinput thread from using libinput until
+ * wlr_libinput_device_release is called. Calls can be nested. Must be called
+ * from the main loop. Does nothing if there is no libinput thread.
+ */
+void wlr_libinput_device_acquire(struct wlr_input_device *dev);
+void wlr_libinput_device_release(struct wlr_input_device *dev);
 
 bool wlr_backend_is_libinput(struct wlr_backend *backend);
 bool wlr_input_device_is_libinput(struct wlr_input_device *device);
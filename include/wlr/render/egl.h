@@ -38,6 +38,8 @@ struct wlr_egl {
 		bool image_dma_buf_export_mesa;
 		bool image_dmabuf_import_ext;
 		bool image_dmabuf_import_modifiers_ext;
+		bool native_fence_sync_android;
+		bool wait_sync_khr;
 		bool swap_buffers_with_damage_ext;
 		bool swap_buffers_with_damage_khr;
 	} exts;
@@ -112,4 +114,19 @@ bool wlr_egl_swap_buffers(struct wlr_egl *egl, EGLSurface surface,
 
 bool wlr_egl_destroy_surface(struct wlr_egl *egl, EGLSurface surface);
 
+/**
+ * Inserts a fence in the command stream of the current context and exports it
+ * as a sync_file FD. The FD becomes readable once all previously submitted
+ * rendering commands have completed. Returns -1 if native fences aren't
+ * supported or on error.
+ */
+int wlr_egl_dup_fence_fd(struct wlr_egl *egl);
+
+/**
+ * Makes the GPU wait for the sync_file FD to be signalled before executing
+ * commands submitted to the current context afterwards. The CPU doesn't block.
+ * The FD isn't consumed.
+ */
+bool wlr_egl_wait_fence_fd(struct wlr_egl *egl, int fence_fd);
+
 #endif
@@ -53,13 +53,23 @@ struct wlr_renderer_impl {
 		uint32_t *flags, uint32_t stride, uint32_t width, uint32_t height,
 		uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y,
 		void *data);
+	bool (*copy_to_dmabuf)(struct wlr_renderer *renderer,
+		struct wlr_dmabuf_attributes *dst, uint32_t *flags,
+		pixman_region32_t *region, int32_t src_x, int32_t src_y);
+	bool (*bind_buffer)(struct wlr_renderer *renderer,
+		struct wlr_buffer *buffer);
 	struct wlr_texture *(*texture_from_pixels)(struct wlr_renderer *renderer,
 		enum wl_shm_format fmt, uint32_t stride, uint32_t width,
 		uint32_t height, const void *data);
+	struct wlr_texture *(*texture_from_wl_shm)(struct wlr_renderer *renderer,
+		struct wl_resource *buffer);
 	struct wlr_texture *(*texture_from_wl_drm)(struct wlr_renderer *renderer,
 		struct wl_resource *data);
 	struct wlr_texture *(*texture_from_dmabuf)(struct wlr_renderer *renderer,
 		struct wlr_dmabuf_attributes *attribs);
+	bool (*wait_fence_supported)(struct wlr_renderer *renderer);
+	bool (*wait_fence)(struct wlr_renderer *renderer, int fence_fd);
+	int (*export_fence)(struct wlr_renderer *renderer);
 	void (*destroy)(struct wlr_renderer *renderer);
 	void (*init_wl_display)(struct wlr_renderer *renderer,
 		struct wl_display *wl_display);
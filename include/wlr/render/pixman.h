@@ -0,0 +1,32 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_RENDER_PIXMAN_H
+#define WLR_RENDER_PIXMAN_H
+
+#include <pixman.h>
+#include <wlr/render/wlr_renderer.h>
+
+/**
+ * Creates a software renderer drawing with pixman. It doesn't need a GPU nor
+ * EGL.
+ */
+struct wlr_renderer *wlr_pixman_renderer_create(void);
+bool wlr_renderer_is_pixman(struct wlr_renderer *wlr_renderer);
+bool wlr_texture_is_pixman(struct wlr_texture *texture);
+
+/**
+ * Sets the image the renderer draws into, the equivalent of making an EGL
+ * surface current for the GLES2 renderer. The renderer holds a reference to
+ * the image until another one is bound. Passing NULL unbinds the image.
+ */
+void wlr_pixman_renderer_bind_image(struct wlr_renderer *wlr_renderer,
+	pixman_image_t *image);
+pixman_image_t *wlr_pixman_texture_get_image(struct wlr_texture *texture);
+
+#endif
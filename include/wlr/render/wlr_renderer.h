@@ -9,6 +9,7 @@
 #ifndef WLR_RENDER_WLR_RENDERER_H
 #define WLR_RENDER_WLR_RENDERER_H
 
+#include <pixman.h>
 #include <stdint.h>
 #include <wayland-server-protocol.h>
 #include <wlr/render/egl.h>
@@ -21,6 +22,7 @@ enum wlr_renderer_read_pixels_flags {
 
 struct wlr_renderer_impl;
 struct wlr_drm_format_set;
+struct wlr_buffer;
 
 struct wlr_renderer {
 	const struct wlr_renderer_impl *impl;
@@ -102,11 +104,52 @@ const struct wlr_drm_format_set *wlr_renderer_get_dmabuf_formats(
 bool wlr_renderer_read_pixels(struct wlr_renderer *r, enum wl_shm_format fmt,
 	uint32_t *flags, uint32_t stride, uint32_t width, uint32_t height,
 	uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y, void *data);
+/**
+ * Copies a region of the currently bound surface into a DMA-BUF without going
+ * through the CPU. The copy is asynchronous, use `wlr_renderer_export_fence`
+ * to know when it's done.
+ *
+ * `region` is in surface coordinates, the point (`src_x`, `src_y`) of the
+ * surface is copied to (0, 0) in the DMA-BUF. The DMA-BUF is imported once
+ * for all of the region's rectangles.
+ *
+ * `flags` is filled with the `enum wlr_renderer_read_pixels_flags` that apply
+ * to the whole DMA-BUF. Destination coordinates are given before applying
+ * them.
+ */
+bool wlr_renderer_copy_to_dmabuf(struct wlr_renderer *r,
+	struct wlr_dmabuf_attributes *dst, uint32_t *flags,
+	pixman_region32_t *region, int32_t src_x, int32_t src_y);
+/**
+ * Makes `wlr_renderer_read_pixels` and `wlr_renderer_copy_to_dmabuf` read from
+ * a buffer instead of the currently bound surface, e.g. to capture a client
+ * buffer scanned out directly. Passing NULL restores the surface.
+ */
+bool wlr_renderer_bind_buffer(struct wlr_renderer *r,
+	struct wlr_buffer *buffer);
 /**
  * Checks if a format is supported.
  */
 bool wlr_renderer_format_supported(struct wlr_renderer *r,
 	enum wl_shm_format fmt);
+/**
+ * Checks if the renderer can import sync_file fences and make rendering
+ * operations wait for them, see `wlr_renderer_wait_fence`.
+ */
+bool wlr_renderer_wait_fence_supported(struct wlr_renderer *r);
+/**
+ * Makes rendering operations submitted after this call wait for the sync_file
+ * `fence_fd` to be signalled. The CPU doesn't block. The FD isn't consumed.
+ *
+ * Returns false if the renderer doesn't support explicit synchronization.
+ */
+bool wlr_renderer_wait_fence(struct wlr_renderer *r, int fence_fd);
+/**
+ * Returns a sync_file FD which will be signalled once all rendering operations
+ * submitted so far have completed, or -1 if the renderer doesn't support
+ * explicit synchronization. The caller owns the FD.
+ */
+int wlr_renderer_export_fence(struct wlr_renderer *r);
 void wlr_renderer_init_wl_display(struct wlr_renderer *r,
 	struct wl_display *wl_display);
 /**
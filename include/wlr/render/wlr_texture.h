@@ -30,6 +30,15 @@ struct wlr_texture *wlr_texture_from_pixels(struct wlr_renderer *renderer,
 	enum wl_shm_format wl_fmt, uint32_t stride, uint32_t width, uint32_t height,
 	const void *data);
 
+/**
+ * Create a new texture referencing the memory of a wl_shm buffer, without
+ * copying it. The buffer must not be released while the texture is in use.
+ * Returns NULL if the renderer can't sample wl_shm buffers directly. The
+ * returned texture is immutable.
+ */
+struct wlr_texture *wlr_texture_from_wl_shm(struct wlr_renderer *renderer,
+	struct wl_resource *buffer);
+
 /**
  * Create a new texture from a wl_drm resource. The returned texture is
  * immutable.
@@ -29,6 +29,11 @@ struct wlr_buffer {
 	bool released;
 	size_t n_refs;
 
+	struct {
+		// emitted when the last reference is dropped
+		struct wl_signal destroy;
+	} events;
+
 	struct wl_listener resource_destroy;
 };
 
@@ -27,6 +27,10 @@ struct wlr_idle {
 	struct wl_event_loop *event_loop;
 	bool enabled;
 
+	// A single timer fires at the earliest deadline of all idle timeouts
+	struct wl_event_source *idle_source;
+	int64_t next_deadline; // CLOCK_MONOTONIC milliseconds, 0 if not armed
+
 	struct wl_listener display_destroy;
 	struct {
 		struct wl_signal activity_notify;
@@ -39,9 +43,10 @@ struct wlr_idle {
 struct wlr_idle_timeout {
 	struct wl_resource *resource;
 	struct wl_list link;
+	struct wlr_idle *idle;
 	struct wlr_seat *seat;
 
-	struct wl_event_source *idle_source;
+	int64_t last_activity; // CLOCK_MONOTONIC milliseconds
 	bool idle_state;
 	bool enabled;
 	uint32_t timeout; // milliseconds
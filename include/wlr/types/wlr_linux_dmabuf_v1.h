@@ -19,6 +19,14 @@ struct wlr_dmabuf_v1_buffer {
 	struct wl_resource *params_resource;
 	struct wlr_dmabuf_attributes attributes;
 	bool has_modifier;
+	// Texture imported when validating the buffer, handed over to the first
+	// wlr_buffer created from it. NULL once taken or once the renderer is
+	// destroyed.
+	struct wlr_texture *texture;
+
+	// private state
+
+	struct wl_listener renderer_destroy;
 };
 
 /**
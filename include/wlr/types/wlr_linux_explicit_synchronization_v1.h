@@ -0,0 +1,73 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_TYPES_WLR_LINUX_EXPLICIT_SYNCHRONIZATION_H
+#define WLR_TYPES_WLR_LINUX_EXPLICIT_SYNCHRONIZATION_H
+
+#include <wayland-server.h>
+
+struct wlr_linux_surface_synchronization_v1_state {
+	int acquire_fence_fd; // -1 if unset
+	struct wlr_linux_buffer_release_v1 *buffer_release;
+};
+
+struct wlr_linux_surface_synchronization_v1 {
+	struct wl_resource *resource;
+	struct wlr_surface *surface;
+	struct wlr_linux_explicit_synchronization_v1 *explicit_synchronization;
+	struct wl_list link; // wlr_linux_explicit_synchronization_v1::surfaces
+
+	// The cached state is latched when the client commits, and becomes
+	// current when the surface state is applied. For synchronized
+	// sub-surfaces, this happens when the parent commits.
+	struct wlr_linux_surface_synchronization_v1_state pending, cached, current;
+
+	struct wl_listener surface_destroy;
+	struct wl_listener surface_client_commit;
+	struct wl_listener surface_precommit;
+	struct wl_listener surface_commit;
+};
+
+struct wlr_linux_buffer_release_v1 {
+	struct wl_resource *resource;
+	struct wlr_renderer *renderer;
+	struct wlr_buffer *buffer;
+	// The surface synchronization state holding the release, if any
+	struct wlr_linux_surface_synchronization_v1_state *state;
+
+	struct wl_listener buffer_destroy;
+};
+
+struct wlr_linux_explicit_synchronization_v1 {
+	struct wl_global *global;
+	struct wlr_renderer *renderer;
+	struct wl_list resources; // wl_resource_get_link
+	struct wl_list surfaces; // wlr_linux_surface_synchronization_v1::link
+
+	struct {
+		struct wl_signal destroy;
+	} events;
+
+	struct wl_listener display_destroy;
+	struct wl_listener renderer_destroy;
+};
+
+/**
+ * Advertise explicit synchronization support to clients. Client acquire fences
+ * are waited on by the renderer before sampling buffers, and release fences are
+ * signalled once the compositor has stopped reading a buffer.
+ *
+ * Returns NULL if the renderer can't wait for fences.
+ */
+struct wlr_linux_explicit_synchronization_v1 *
+	wlr_linux_explicit_synchronization_v1_create(struct wl_display *display,
+	struct wlr_renderer *renderer);
+void wlr_linux_explicit_synchronization_v1_destroy(
+	struct wlr_linux_explicit_synchronization_v1 *explicit_sync);
+
+#endif
@@ -49,6 +49,7 @@ struct wlr_output_cursor {
 enum wlr_output_state_field {
 	WLR_OUTPUT_STATE_BUFFER = 1 << 0,
 	WLR_OUTPUT_STATE_DAMAGE = 1 << 1,
+	WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED = 1 << 2,
 };
 
 enum wlr_output_state_buffer_type {
@@ -66,6 +67,9 @@ struct wlr_output_state {
 	// only valid if WLR_OUTPUT_STATE_BUFFER
 	enum wlr_output_state_buffer_type buffer_type;
 	struct wlr_buffer *buffer; // if WLR_OUTPUT_STATE_BUFFER_SCANOUT
+
+	// only valid if WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED
+	bool adaptive_sync_enabled;
 };
 
 struct wlr_output_impl;
@@ -105,12 +109,19 @@ struct wlr_output {
 	float scale;
 	enum wl_output_subpixel subpixel;
 	enum wl_output_transform transform;
+	// Adaptive sync (variable refresh rate) lets the display refresh as soon
+	// as a new frame is committed, within the limits of the panel
+	bool adaptive_sync_supported;
+	bool adaptive_sync_enabled;
 
 	bool needs_frame;
 	// damage for cursors and fullscreen surface, in output-local coordinates
 	pixman_region32_t damage;
 	bool frame_pending;
 	float transform_matrix[9];
+	// Incremented before the `precommit` event, and reverted if the commit
+	// fails: a failed commit and the next attempt share the same value
+	uint32_t commit_seq;
 
 	struct wlr_output_state pending;
 
@@ -176,6 +187,8 @@ struct wlr_output_event_present {
 	// refresh may occur. Zero if unknown.
 	int refresh; // nsec
 	uint32_t flags; // enum wlr_output_present_flag
+	// Value of `commit_seq` for the commit which has been presented
+	uint32_t commit_seq;
 };
 
 struct wlr_surface;
@@ -260,6 +273,13 @@ bool wlr_output_preferred_read_format(struct wlr_output *output,
  */
 void wlr_output_set_damage(struct wlr_output *output,
 	pixman_region32_t *damage);
+/**
+ * Enables or disables adaptive sync (ie. variable refresh rate) on this
+ * output. This is just a hint, the backend is free to ignore this setting: the
+ * state is applied on the next commit, after which `adaptive_sync_enabled`
+ * reflects whether it is actually in effect.
+ */
+void wlr_output_enable_adaptive_sync(struct wlr_output *output, bool enabled);
 /**
  * Commit the pending output state. If `wlr_output_attach_render` has been
  * called, the pending frame will be submitted for display.
@@ -74,7 +74,8 @@ void wlr_output_damage_destroy(struct wlr_output_damage *output_damage);
 bool wlr_output_damage_attach_render(struct wlr_output_damage *output_damage,
 	bool *needs_frame, pixman_region32_t *buffer_damage);
 /**
- * Accumulates damage and schedules a `frame` event.
+ * Accumulates damage and schedules a `frame` event. Damage outside of the
+ * output is discarded, no frame is scheduled if nothing is left.
  */
 void wlr_output_damage_add(struct wlr_output_damage *output_damage,
 	pixman_region32_t *damage);
@@ -83,7 +84,8 @@ void wlr_output_damage_add(struct wlr_output_damage *output_damage,
  */
 void wlr_output_damage_add_whole(struct wlr_output_damage *output_damage);
 /**
- * Accumulates damage from a box and schedules a `frame` event.
+ * Accumulates damage from a box and schedules a `frame` event. No frame is
+ * scheduled if the box doesn't intersect the output.
  */
 void wlr_output_damage_add_box(struct wlr_output_damage *output_damage,
 	struct wlr_box *box);
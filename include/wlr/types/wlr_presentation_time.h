@@ -30,12 +30,23 @@ struct wlr_presentation {
 struct wlr_presentation_feedback {
 	struct wl_resource *resource;
 	struct wlr_presentation *presentation;
+	// NULL if the surface has been destroyed after the content was sampled
 	struct wlr_surface *surface;
 	bool committed;
+	bool sampled;
 	struct wl_list link; // wlr_presentation::feedbacks
 
+	// Only when the content has been sampled on an output
+	struct wlr_output *output;
+	bool output_committed;
+	uint32_t output_commit_seq;
+	bool zero_copy;
+
 	struct wl_listener surface_commit;
 	struct wl_listener surface_destroy;
+	struct wl_listener output_precommit;
+	struct wl_listener output_present;
+	struct wl_listener output_destroy;
 };
 
 struct wlr_presentation_event {
@@ -48,12 +59,33 @@ struct wlr_presentation_event {
 };
 
 struct wlr_backend;
+struct wlr_output;
 
 struct wlr_presentation *wlr_presentation_create(struct wl_display *display,
 	struct wlr_backend *backend);
 void wlr_presentation_destroy(struct wlr_presentation *presentation);
+/**
+ * Send presentation feedback for the current content of the surface. The
+ * compositor is responsible for only calling this for surfaces which have
+ * been displayed in the presented frame.
+ *
+ * Content sampled with wlr_presentation_surface_sampled_on_output is not
+ * affected.
+ */
 void wlr_presentation_send_surface_presented(
 	struct wlr_presentation *presentation, struct wlr_surface *surface,
 	struct wlr_presentation_event *event);
+/**
+ * Mark the current content of the surface as sampled for the next commit of
+ * the output. This should be called when rendering the surface, or when
+ * attaching its buffer for direct scan-out.
+ *
+ * Presentation feedback is then sent automatically when that output commit is
+ * presented, with the ZERO_COPY flag only if the surface's buffer was scanned
+ * out. If the commit is never presented, the feedback is discarded.
+ */
+void wlr_presentation_surface_sampled_on_output(
+	struct wlr_presentation *presentation, struct wlr_surface *surface,
+	struct wlr_output *output);
 
 #endif
@@ -10,6 +10,7 @@
 #define WLR_TYPES_WLR_SCREENCOPY_V1_H
 
 #include <stdbool.h>
+#include <time.h>
 #include <wayland-server.h>
 #include <wlr/types/wlr_box.h>
 
@@ -27,20 +28,36 @@ struct wlr_screencopy_manager_v1 {
 	void *data;
 };
 
+struct wlr_screencopy_v1_client {
+	int ref;
+	struct wlr_screencopy_manager_v1 *manager;
+	struct wl_list damages;
+};
+
 struct wlr_screencopy_frame_v1 {
 	struct wl_resource *resource;
 	struct wlr_screencopy_manager_v1 *manager;
+	struct wlr_screencopy_v1_client *client;
 	struct wl_list link;
 
 	enum wl_shm_format format;
+	uint32_t fourcc; // DRM format for DMA-BUFs, 0 if unsupported
 	struct wlr_box box;
 	int stride;
 
 	bool overlay_cursor, cursor_locked;
 
+	bool with_damage;
+
 	struct wl_shm_buffer *buffer;
+	struct wlr_dmabuf_v1_buffer *dma_buffer;
 	struct wl_listener buffer_destroy;
 
+	// Set while waiting for a DMA-BUF copy to complete
+	int fence_fd;
+	struct wl_event_source *fence_source;
+	struct timespec ready_time;
+
 	struct wlr_output *output;
 	struct wl_listener output_precommit;
 
@@ -51,6 +51,16 @@ struct wlr_seat_client {
 	// set of serials which were sent to the client on this seat
 	// for use by wlr_seat_client_{next_serial,validate_event_serial}
 	struct wlr_serial_ringset serials;
+
+	// input events sent to the client on this seat, and their size on the wire
+	struct {
+		uint64_t events;
+		uint64_t bytes;
+	} stats;
+
+	// touch motion events are grouped in a single wl_touch.frame sent at the
+	// end of the event loop iteration
+	struct wl_event_source *touch_frame_idle;
 };
 
 struct wlr_touch_point {
@@ -62,6 +72,8 @@ struct wlr_touch_point {
 	struct wlr_seat_client *focus_client;
 	double sx, sy;
 
+	bool frame_pending; // a motion event is waiting for a wl_touch.frame
+
 	struct wl_listener surface_destroy;
 	struct wl_listener focus_surface_destroy;
 
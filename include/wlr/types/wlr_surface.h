@@ -99,6 +99,13 @@ struct wlr_surface {
 	void *role_data; // role-specific data
 
 	struct {
+		// emitted when the client commits, before the pending state is
+		// applied or cached (for synchronized sub-surfaces), `pending`
+		// contains the state committed by the client
+		struct wl_signal client_commit;
+		// emitted before the pending state is applied, `pending` contains the
+		// state about to be committed
+		struct wl_signal precommit;
 		struct wl_signal commit;
 		struct wl_signal new_subsurface;
 		struct wl_signal destroy;
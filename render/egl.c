@@ -1,7 +1,9 @@
 #include <assert.h>
 #include <drm_fourcc.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <wlr/render/egl.h>
 #include <wlr/util/log.h>
 #include <wlr/util/region.h>
@@ -196,6 +198,12 @@ bool wlr_egl_init(struct wlr_egl *egl, EGLenum platform, void *remote_display,
 		check_egl_ext(egl->exts_str, "EGL_MESA_image_dma_buf_export") &&
 		eglExportDMABUFImageQueryMESA && eglExportDMABUFImageMESA;
 
+	egl->exts.native_fence_sync_android =
+		check_egl_ext(egl->exts_str, "EGL_ANDROID_native_fence_sync") &&
+		eglCreateSyncKHR && eglDestroySyncKHR && eglDupNativeFenceFDANDROID;
+	egl->exts.wait_sync_khr =
+		check_egl_ext(egl->exts_str, "EGL_KHR_wait_sync") && eglWaitSyncKHR;
+
 	init_dmabuf_formats(egl);
 
 	egl->exts.bind_wayland_display_wl =
@@ -643,3 +651,61 @@ bool wlr_egl_destroy_surface(struct wlr_egl *egl, EGLSurface surface) {
 	}
 	return eglDestroySurface(egl->display, surface);
 }
+
+int wlr_egl_dup_fence_fd(struct wlr_egl *egl) {
+	if (!egl->exts.native_fence_sync_android) {
+		return -1;
+	}
+
+	EGLSyncKHR sync = eglCreateSyncKHR(egl->display,
+		EGL_SYNC_NATIVE_FENCE_ANDROID, NULL);
+	if (sync == EGL_NO_SYNC_KHR) {
+		wlr_log(WLR_ERROR, "eglCreateSyncKHR failed");
+		return -1;
+	}
+
+	// The native fence is only created once the command stream is flushed
+	glFlush();
+
+	int fd = eglDupNativeFenceFDANDROID(egl->display, sync);
+	eglDestroySyncKHR(egl->display, sync);
+	if (fd == EGL_NO_NATIVE_FENCE_FD_ANDROID) {
+		wlr_log(WLR_ERROR, "eglDupNativeFenceFDANDROID failed");
+		return -1;
+	}
+
+	return fd;
+}
+
+bool wlr_egl_wait_fence_fd(struct wlr_egl *egl, int fence_fd) {
+	if (!egl->exts.native_fence_sync_android || !egl->exts.wait_sync_khr) {
+		return false;
+	}
+
+	// EGL takes ownership of the FD on success
+	int fd = fcntl(fence_fd, F_DUPFD_CLOEXEC, 0);
+	if (fd < 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to duplicate fence FD");
+		return false;
+	}
+
+	const EGLint attribs[] = {
+		EGL_SYNC_NATIVE_FENCE_FD_ANDROID, fd,
+		EGL_NONE,
+	};
+	EGLSyncKHR sync = eglCreateSyncKHR(egl->display,
+		EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+	if (sync == EGL_NO_SYNC_KHR) {
+		wlr_log(WLR_ERROR, "Failed to import fence FD");
+		close(fd);
+		return false;
+	}
+
+	EGLint ret = eglWaitSyncKHR(egl->display, sync, 0);
+	eglDestroySyncKHR(egl->display, sync);
+	if (ret != EGL_TRUE) {
+		wlr_log(WLR_ERROR, "eglWaitSyncKHR failed");
+		return false;
+	}
+	return true;
+}
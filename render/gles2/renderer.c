@@ -9,10 +9,13 @@
 #include <wlr/render/egl.h>
 #include <wlr/render/interface.h>
 #include <wlr/render/wlr_renderer.h>
+#include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_matrix.h>
 #include <wlr/util/log.h>
 #include "glapi.h"
 #include "render/gles2.h"
+#include "util/pixel.h"
+#include "util/trace.h"
 
 static const struct wlr_renderer_impl renderer_impl;
 
@@ -39,6 +42,7 @@ static void gles2_begin(struct wlr_renderer *wlr_renderer, uint32_t width,
 	glViewport(0, 0, width, height);
 	renderer->viewport_width = width;
 	renderer->viewport_height = height;
+	renderer->draw_calls = 0;
 
 	// enable transparency
 	glEnable(GL_BLEND);
@@ -51,8 +55,9 @@ static void gles2_begin(struct wlr_renderer *wlr_renderer, uint32_t width,
 }
 
 static void gles2_end(struct wlr_renderer *wlr_renderer) {
-	gles2_get_renderer_in_context(wlr_renderer);
-	// no-op
+	struct wlr_gles2_renderer *renderer =
+		gles2_get_renderer_in_context(wlr_renderer);
+	trace_counter("wlr_gles2_draw_calls", NULL, renderer->draw_calls);
 }
 
 static void gles2_clear(struct wlr_renderer *wlr_renderer,
@@ -84,7 +89,7 @@ static void gles2_scissor(struct wlr_renderer *wlr_renderer,
 	POP_GLES2_DEBUG;
 }
 
-static void draw_quad(void) {
+static void draw_quad(struct wlr_gles2_renderer *renderer) {
 	GLfloat verts[] = {
 		1, 0, // top right
 		0, 0, // top left
@@ -108,6 +113,8 @@ static void draw_quad(void) {
 
 	glDisableVertexAttribArray(0);
 	glDisableVertexAttribArray(1);
+
+	renderer->draw_calls++;
 }
 
 static bool gles2_render_texture_with_matrix(struct wlr_renderer *wlr_renderer,
@@ -166,7 +173,7 @@ static bool gles2_render_texture_with_matrix(struct wlr_renderer *wlr_renderer,
 	glUniform1i(shader->tex, 0);
 	glUniform1f(shader->alpha, alpha);
 
-	draw_quad();
+	draw_quad(renderer);
 
 	POP_GLES2_DEBUG;
 	return true;
@@ -188,7 +195,7 @@ static void gles2_render_quad_with_matrix(struct wlr_renderer *wlr_renderer,
 
 	glUniformMatrix3fv(renderer->shaders.quad.proj, 1, GL_FALSE, transposition);
 	glUniform4f(renderer->shaders.quad.color, color[0], color[1], color[2], color[3]);
-	draw_quad();
+	draw_quad(renderer);
 	POP_GLES2_DEBUG;
 }
 
@@ -207,7 +214,7 @@ static void gles2_render_ellipse_with_matrix(struct wlr_renderer *wlr_renderer,
 
 	glUniformMatrix3fv(renderer->shaders.ellipse.proj, 1, GL_FALSE, transposition);
 	glUniform4f(renderer->shaders.ellipse.color, color[0], color[1], color[2], color[3]);
-	draw_quad();
+	draw_quad(renderer);
 	POP_GLES2_DEBUG;
 }
 
@@ -280,6 +287,28 @@ static enum wl_shm_format gles2_preferred_read_format(
 	return WL_SHM_FORMAT_XBGR8888;
 }
 
+/**
+ * Returns true if the framebuffer being read from stores its rows bottom-up,
+ * as EGL surfaces do.
+ */
+static bool gles2_read_bottom_up(struct wlr_gles2_renderer *renderer) {
+	return renderer->bound_buffer.fbo == 0 || renderer->bound_buffer.inverted_y;
+}
+
+/**
+ * Converts a range of rows of the framebuffer being read from, counted from
+ * the top, to the GL window coordinate of its first row.
+ */
+static GLint gles2_read_y(struct wlr_gles2_renderer *renderer, uint32_t y,
+		uint32_t height) {
+	if (!gles2_read_bottom_up(renderer)) {
+		return y;
+	}
+	uint32_t fb_height = renderer->bound_buffer.fbo != 0 ?
+		renderer->bound_buffer.height : renderer->viewport_height;
+	return fb_height - y - height;
+}
+
 static bool gles2_read_pixels(struct wlr_renderer *wlr_renderer,
 		enum wl_shm_format wl_fmt, uint32_t *flags, uint32_t stride,
 		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
@@ -293,10 +322,12 @@ static bool gles2_read_pixels(struct wlr_renderer *wlr_renderer,
 		return false;
 	}
 
+	GLint gl_format = fmt->gl_format;
+	bool swap_rb = false;
 	if (fmt->gl_format == GL_BGRA_EXT && !renderer->exts.read_format_bgra_ext) {
-		wlr_log(WLR_ERROR,
-			"Cannot read pixels: missing GL_EXT_read_format_bgra extension");
-		return false;
+		// GL_RGBA is always readable, swap the channels ourselves
+		gl_format = GL_RGBA;
+		swap_rb = true;
 	}
 
 	PUSH_GLES2_DEBUG;
@@ -307,20 +338,43 @@ static bool gles2_read_pixels(struct wlr_renderer *wlr_renderer,
 	glGetError(); // Clear the error flag
 
 	unsigned char *p = (unsigned char *)data + dst_y * stride;
-	uint32_t pack_stride = width * fmt->bpp / 8;
+	uint32_t row_bytes = width * fmt->bpp / 8;
+	// Rows are aligned to GL_PACK_ALIGNMENT, 4 by default
+	uint32_t pack_stride = (row_bytes + 3) & ~3u;
 	if (pack_stride == stride && dst_x == 0 && flags != NULL) {
 		// Under these particular conditions, we can read the pixels with only
 		// one glReadPixels call
-		glReadPixels(src_x, renderer->viewport_height - height - src_y,
-			width, height, fmt->gl_format, fmt->gl_type, p);
-		*flags = WLR_RENDERER_READ_PIXELS_Y_INVERT;
+		glReadPixels(src_x, gles2_read_y(renderer, src_y, height),
+			width, height, gl_format, fmt->gl_type, p);
+		if (swap_rb) {
+			pixel_swap_rb_row((uint32_t *)p, (uint32_t *)p, width * height);
+		}
+		*flags = gles2_read_bottom_up(renderer) ?
+			WLR_RENDERER_READ_PIXELS_Y_INVERT : 0;
 	} else {
-		// Unfortunately GLES2 doesn't support GL_PACK_*, so we have to read
-		// the lines out row by row
-		for (size_t i = src_y; i < src_y + height; ++i) {
-			glReadPixels(src_x, src_y + height - i - 1, width, 1, fmt->gl_format,
-				fmt->gl_type, p + i * stride + dst_x * fmt->bpp / 8);
+		// Unfortunately GLES2 doesn't support GL_PACK_ROW_LENGTH, so read the
+		// whole rectangle in one go and copy it into place
+		void *pixels = malloc(pack_stride * height);
+		if (pixels == NULL) {
+			wlr_log(WLR_ERROR, "Allocation failed");
+			POP_GLES2_DEBUG;
+			return false;
+		}
+
+		glReadPixels(src_x, gles2_read_y(renderer, src_y, height),
+			width, height, gl_format, fmt->gl_type, pixels);
+
+		bool flip_y = gles2_read_bottom_up(renderer);
+		unsigned char *dst = p + dst_x * fmt->bpp / 8;
+		if (swap_rb) {
+			pixel_copy_rect_swap_rb(dst, stride, pixels, pack_stride,
+				width, height, flip_y);
+		} else {
+			pixel_copy_rect(dst, stride, pixels, pack_stride,
+				row_bytes, height, flip_y);
 		}
+		free(pixels);
+
 		if (flags != NULL) {
 			*flags = 0;
 		}
@@ -331,6 +385,140 @@ static bool gles2_read_pixels(struct wlr_renderer *wlr_renderer,
 	return glGetError() == GL_NO_ERROR;
 }
 
+static bool gles2_copy_to_dmabuf(struct wlr_renderer *wlr_renderer,
+		struct wlr_dmabuf_attributes *dst, uint32_t *flags,
+		pixman_region32_t *region, int32_t src_x, int32_t src_y) {
+	struct wlr_gles2_renderer *renderer =
+		gles2_get_renderer_in_context(wlr_renderer);
+
+	if (!glEGLImageTargetTexture2DOES ||
+			!renderer->egl->exts.image_dmabuf_import_ext) {
+		wlr_log(WLR_ERROR, "Cannot copy to DMA-BUF: EGL extension "
+			"unavailable");
+		return false;
+	}
+
+	EGLImageKHR image = wlr_egl_create_image_from_dmabuf(renderer->egl, dst);
+	if (image == NULL) {
+		return false;
+	}
+
+	PUSH_GLES2_DEBUG;
+
+	glGetError(); // Clear the error flag
+
+	GLuint tex;
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, image);
+
+	// Rows are copied in the order they're stored in the framebuffer, which
+	// y-inverts the DMA-BUF if they're stored bottom-up
+	bool bottom_up = gles2_read_bottom_up(renderer);
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(region, &nrects);
+	for (int i = 0; i < nrects; ++i) {
+		pixman_box32_t *r = &rects[i];
+		int32_t width = r->x2 - r->x1, height = r->y2 - r->y1;
+		int32_t dst_x = r->x1 - src_x, dst_y = r->y1 - src_y;
+		GLint dst_y_gl = bottom_up ? dst->height - dst_y - height : dst_y;
+		glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst_x, dst_y_gl,
+			r->x1, gles2_read_y(renderer, r->y1, height), width, height);
+	}
+	glFlush();
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDeleteTextures(1, &tex);
+
+	bool ok = glGetError() == GL_NO_ERROR;
+
+	POP_GLES2_DEBUG;
+
+	wlr_egl_destroy_image(renderer->egl, image);
+
+	*flags = bottom_up ? WLR_RENDERER_READ_PIXELS_Y_INVERT : 0;
+	return ok;
+}
+
+static void gles2_unbind_buffer(struct wlr_gles2_renderer *renderer) {
+	if (renderer->bound_buffer.fbo == 0) {
+		return;
+	}
+
+	PUSH_GLES2_DEBUG;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &renderer->bound_buffer.fbo);
+	glDeleteTextures(1, &renderer->bound_buffer.tex);
+	POP_GLES2_DEBUG;
+
+	wlr_egl_destroy_image(renderer->egl, renderer->bound_buffer.image);
+	memset(&renderer->bound_buffer, 0, sizeof(renderer->bound_buffer));
+}
+
+static bool gles2_bind_buffer(struct wlr_renderer *wlr_renderer,
+		struct wlr_buffer *buffer) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+	if (!wlr_egl_is_current(renderer->egl)) {
+		wlr_egl_make_current(renderer->egl, EGL_NO_SURFACE, NULL);
+	}
+
+	gles2_unbind_buffer(renderer);
+	if (buffer == NULL) {
+		return true;
+	}
+
+	struct wlr_dmabuf_attributes attribs;
+	if (!wlr_buffer_get_dmabuf(buffer, &attribs)) {
+		wlr_log(WLR_DEBUG, "Cannot bind buffer: not a DMA-BUF");
+		return false;
+	}
+
+	if (!glEGLImageTargetTexture2DOES ||
+			!renderer->egl->exts.image_dmabuf_import_ext) {
+		wlr_log(WLR_ERROR, "Cannot bind buffer: EGL extension unavailable");
+		return false;
+	}
+
+	EGLImageKHR image = wlr_egl_create_image_from_dmabuf(renderer->egl,
+		&attribs);
+	if (image == NULL) {
+		return false;
+	}
+
+	PUSH_GLES2_DEBUG;
+
+	GLuint tex;
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, image);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLuint fbo;
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+		GL_TEXTURE_2D, tex, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+	POP_GLES2_DEBUG;
+
+	renderer->bound_buffer.image = image;
+	renderer->bound_buffer.tex = tex;
+	renderer->bound_buffer.fbo = fbo;
+	renderer->bound_buffer.height = attribs.height;
+	renderer->bound_buffer.inverted_y =
+		(attribs.flags & WLR_DMABUF_ATTRIBUTES_FLAGS_Y_INVERT) != 0;
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		wlr_log(WLR_ERROR, "Cannot bind buffer: incomplete framebuffer "
+			"(status 0x%X)", status);
+		gles2_unbind_buffer(renderer);
+		return false;
+	}
+
+	return true;
+}
+
 static struct wlr_texture *gles2_texture_from_pixels(
 		struct wlr_renderer *wlr_renderer, enum wl_shm_format wl_fmt,
 		uint32_t stride, uint32_t width, uint32_t height, const void *data) {
@@ -352,6 +540,29 @@ static struct wlr_texture *gles2_texture_from_dmabuf(
 	return wlr_gles2_texture_from_dmabuf(renderer->egl, attribs);
 }
 
+static bool gles2_wait_fence_supported(struct wlr_renderer *wlr_renderer) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+	return renderer->egl->exts.native_fence_sync_android &&
+		renderer->egl->exts.wait_sync_khr;
+}
+
+static bool gles2_wait_fence(struct wlr_renderer *wlr_renderer,
+		int fence_fd) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+	if (!wlr_egl_is_current(renderer->egl)) {
+		wlr_egl_make_current(renderer->egl, EGL_NO_SURFACE, NULL);
+	}
+	return wlr_egl_wait_fence_fd(renderer->egl, fence_fd);
+}
+
+static int gles2_export_fence(struct wlr_renderer *wlr_renderer) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+	if (!wlr_egl_is_current(renderer->egl)) {
+		wlr_egl_make_current(renderer->egl, EGL_NO_SURFACE, NULL);
+	}
+	return wlr_egl_dup_fence_fd(renderer->egl);
+}
+
 static void gles2_init_wl_display(struct wlr_renderer *wlr_renderer,
 		struct wl_display *wl_display) {
 	struct wlr_gles2_renderer *renderer =
@@ -366,6 +577,8 @@ static void gles2_destroy(struct wlr_renderer *wlr_renderer) {
 
 	wlr_egl_make_current(renderer->egl, EGL_NO_SURFACE, NULL);
 
+	gles2_unbind_buffer(renderer);
+
 	PUSH_GLES2_DEBUG;
 	glDeleteProgram(renderer->shaders.quad.program);
 	glDeleteProgram(renderer->shaders.ellipse.program);
@@ -398,9 +611,14 @@ static const struct wlr_renderer_impl renderer_impl = {
 	.get_dmabuf_formats = gles2_get_dmabuf_formats,
 	.preferred_read_format = gles2_preferred_read_format,
 	.read_pixels = gles2_read_pixels,
+	.copy_to_dmabuf = gles2_copy_to_dmabuf,
+	.bind_buffer = gles2_bind_buffer,
 	.texture_from_pixels = gles2_texture_from_pixels,
 	.texture_from_wl_drm = gles2_texture_from_wl_drm,
 	.texture_from_dmabuf = gles2_texture_from_dmabuf,
+	.wait_fence_supported = gles2_wait_fence_supported,
+	.wait_fence = gles2_wait_fence,
+	.export_fence = gles2_export_fence,
 	.init_wl_display = gles2_init_wl_display,
 };
 
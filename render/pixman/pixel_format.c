@@ -0,0 +1,100 @@
+#include <pixman.h>
+#include "render/pixman.h"
+
+/*
+ * The wayland formats are little endian while the pixman formats are native
+ * endian, so they match on little endian machines only.
+ */
+static const struct wlr_pixman_pixel_format formats[] = {
+	{
+		.wl_format = WL_SHM_FORMAT_ARGB8888,
+		.pixman_format = PIXMAN_a8r8g8b8,
+		.bpp = 32,
+		.has_alpha = true,
+	},
+	{
+		.wl_format = WL_SHM_FORMAT_XRGB8888,
+		.pixman_format = PIXMAN_x8r8g8b8,
+		.bpp = 32,
+		.has_alpha = false,
+	},
+	{
+		.wl_format = WL_SHM_FORMAT_ABGR8888,
+		.pixman_format = PIXMAN_a8b8g8r8,
+		.bpp = 32,
+		.has_alpha = true,
+	},
+	{
+		.wl_format = WL_SHM_FORMAT_XBGR8888,
+		.pixman_format = PIXMAN_x8b8g8r8,
+		.bpp = 32,
+		.has_alpha = false,
+	},
+	{
+		.wl_format = WL_SHM_FORMAT_RGBA8888,
+		.pixman_format = PIXMAN_r8g8b8a8,
+		.bpp = 32,
+		.has_alpha = true,
+	},
+	{
+		.wl_format = WL_SHM_FORMAT_RGBX8888,
+		.pixman_format = PIXMAN_r8g8b8x8,
+		.bpp = 32,
+		.has_alpha = false,
+	},
+	{
+		.wl_format = WL_SHM_FORMAT_BGRA8888,
+		.pixman_format = PIXMAN_b8g8r8a8,
+		.bpp = 32,
+		.has_alpha = true,
+	},
+	{
+		.wl_format = WL_SHM_FORMAT_BGRX8888,
+		.pixman_format = PIXMAN_b8g8r8x8,
+		.bpp = 32,
+		.has_alpha = false,
+	},
+	{
+		.wl_format = WL_SHM_FORMAT_RGB565,
+		.pixman_format = PIXMAN_r5g6b5,
+		.bpp = 16,
+		.has_alpha = false,
+	},
+};
+
+static const enum wl_shm_format wl_formats[] = {
+	WL_SHM_FORMAT_ARGB8888,
+	WL_SHM_FORMAT_XRGB8888,
+	WL_SHM_FORMAT_ABGR8888,
+	WL_SHM_FORMAT_XBGR8888,
+	WL_SHM_FORMAT_RGBA8888,
+	WL_SHM_FORMAT_RGBX8888,
+	WL_SHM_FORMAT_BGRA8888,
+	WL_SHM_FORMAT_BGRX8888,
+	WL_SHM_FORMAT_RGB565,
+};
+
+const struct wlr_pixman_pixel_format *get_pixman_format_from_wl(
+		enum wl_shm_format fmt) {
+	for (size_t i = 0; i < sizeof(formats) / sizeof(*formats); ++i) {
+		if (formats[i].wl_format == fmt) {
+			return &formats[i];
+		}
+	}
+	return NULL;
+}
+
+const struct wlr_pixman_pixel_format *get_pixman_format_from_pixman(
+		pixman_format_code_t fmt) {
+	for (size_t i = 0; i < sizeof(formats) / sizeof(*formats); ++i) {
+		if (formats[i].pixman_format == fmt) {
+			return &formats[i];
+		}
+	}
+	return NULL;
+}
+
+const enum wl_shm_format *get_pixman_wl_formats(size_t *len) {
+	*len = sizeof(wl_formats) / sizeof(wl_formats[0]);
+	return wl_formats;
+}
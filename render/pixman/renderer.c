@@ -0,0 +1,488 @@
+#define _XOPEN_SOURCE 700
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlr/render/interface.h>
+#include <wlr/types/wlr_buffer.h>
+#include <wlr/types/wlr_matrix.h>
+#include <wlr/util/log.h>
+#include "render/pixman.h"
+
+// Number of segments ellipses are approximated with
+#define ELLIPSE_SEGMENTS 64
+#define POLYGON_MAX_POINTS ELLIPSE_SEGMENTS
+
+static const struct wlr_renderer_impl renderer_impl;
+
+bool wlr_renderer_is_pixman(struct wlr_renderer *wlr_renderer) {
+	return wlr_renderer->impl == &renderer_impl;
+}
+
+static struct wlr_pixman_renderer *pixman_get_renderer(
+		struct wlr_renderer *wlr_renderer) {
+	assert(wlr_renderer_is_pixman(wlr_renderer));
+	return (struct wlr_pixman_renderer *)wlr_renderer;
+}
+
+static struct wlr_pixman_renderer *pixman_get_renderer_in_context(
+		struct wlr_renderer *wlr_renderer) {
+	struct wlr_pixman_renderer *renderer = pixman_get_renderer(wlr_renderer);
+	assert(renderer->image != NULL);
+	return renderer;
+}
+
+void wlr_pixman_renderer_bind_image(struct wlr_renderer *wlr_renderer,
+		pixman_image_t *image) {
+	struct wlr_pixman_renderer *renderer = pixman_get_renderer(wlr_renderer);
+	if (image != NULL) {
+		pixman_image_ref(image);
+	}
+	if (renderer->image != NULL) {
+		pixman_image_unref(renderer->image);
+	}
+	renderer->image = image;
+}
+
+static void color_to_pixman(const float color[static 4], pixman_color_t *out) {
+	// Colors are premultiplied, as are pixman colors
+	out->red = color[0] * 0xFFFF;
+	out->green = color[1] * 0xFFFF;
+	out->blue = color[2] * 0xFFFF;
+	out->alpha = color[3] * 0xFFFF;
+}
+
+/**
+ * Converts a matrix mapping the unit square to normalized device coordinates
+ * into a transform mapping the pixels of a src_width×src_height source to
+ * output pixels. See wlr_matrix_projection.
+ */
+static void get_pixel_transform(struct wlr_pixman_renderer *renderer,
+		const float matrix[static 9], int src_width, int src_height,
+		struct pixman_f_transform *out) {
+	float ndc_to_px[9] = {
+		renderer->width / 2.0f, 0.0f, renderer->width / 2.0f,
+		0.0f, -renderer->height / 2.0f, renderer->height / 2.0f,
+		0.0f, 0.0f, 1.0f,
+	};
+	float px[9];
+	wlr_matrix_multiply(px, ndc_to_px, matrix);
+
+	for (int i = 0; i < 3; ++i) {
+		out->m[i][0] = px[i * 3] / src_width;
+		out->m[i][1] = px[i * 3 + 1] / src_height;
+		out->m[i][2] = px[i * 3 + 2];
+	}
+}
+
+static void transform_point(const struct pixman_f_transform *tr,
+		double x, double y, double *out_x, double *out_y) {
+	struct pixman_f_vector v = { .v = { x, y, 1 } };
+	pixman_f_transform_point(tr, &v);
+	*out_x = v.v[0];
+	*out_y = v.v[1];
+}
+
+/**
+ * Returns the output pixels covered by a transformed source, clipped to the
+ * output. Returns false if the box is empty.
+ */
+static bool get_dst_box(struct wlr_pixman_renderer *renderer,
+		const struct pixman_f_transform *tr, int src_width, int src_height,
+		pixman_box32_t *box) {
+	const double corners[4][2] = {
+		{ 0, 0 },
+		{ src_width, 0 },
+		{ 0, src_height },
+		{ src_width, src_height },
+	};
+	double x1 = INFINITY, y1 = INFINITY, x2 = -INFINITY, y2 = -INFINITY;
+	for (size_t i = 0; i < 4; ++i) {
+		double x, y;
+		transform_point(tr, corners[i][0], corners[i][1], &x, &y);
+		x1 = fmin(x1, x);
+		y1 = fmin(y1, y);
+		x2 = fmax(x2, x);
+		y2 = fmax(y2, y);
+	}
+
+	// Rounding absorbs float imprecision on integer coordinates
+	box->x1 = fmax(floor(x1 + 0.001), 0);
+	box->y1 = fmax(floor(y1 + 0.001), 0);
+	box->x2 = fmin(ceil(x2 - 0.001), renderer->width);
+	box->y2 = fmin(ceil(y2 - 0.001), renderer->height);
+	return box->x1 < box->x2 && box->y1 < box->y2;
+}
+
+static bool is_integer(double v) {
+	return fabs(v - round(v)) < 0.001;
+}
+
+static bool render_image(struct wlr_pixman_renderer *renderer,
+		pixman_image_t *src, int src_width, int src_height,
+		const float matrix[static 9], pixman_image_t *mask) {
+	struct pixman_f_transform tr;
+	get_pixel_transform(renderer, matrix, src_width, src_height, &tr);
+
+	pixman_box32_t box;
+	if (!get_dst_box(renderer, &tr, src_width, src_height, &box)) {
+		return true;
+	}
+
+	bool axis_aligned = tr.m[0][1] == 0 && tr.m[1][0] == 0;
+	if (axis_aligned && tr.m[0][0] == 1 && tr.m[1][1] == 1 &&
+			is_integer(tr.m[0][2]) && is_integer(tr.m[1][2])) {
+		// Plain translation, no need to resample
+		int x = round(tr.m[0][2]);
+		int y = round(tr.m[1][2]);
+		pixman_image_composite32(PIXMAN_OP_OVER, src, mask, renderer->image,
+			0, 0, 0, 0, x, y, src_width, src_height);
+		return true;
+	}
+
+	struct pixman_f_transform inverse;
+	struct pixman_transform transform;
+	if (!pixman_f_transform_invert(&inverse, &tr) ||
+			!pixman_transform_from_pixman_f_transform(&transform, &inverse)) {
+		wlr_log(WLR_DEBUG, "Cannot render image: invalid matrix");
+		return false;
+	}
+
+	// Flips and 90° rotations map pixels to pixels
+	bool pixel_aligned = (axis_aligned &&
+		fabs(tr.m[0][0]) == 1 && fabs(tr.m[1][1]) == 1) ||
+		(tr.m[0][0] == 0 && tr.m[1][1] == 0 &&
+		fabs(tr.m[0][1]) == 1 && fabs(tr.m[1][0]) == 1);
+
+	pixman_image_set_transform(src, &transform);
+	pixman_image_set_filter(src, pixel_aligned ?
+		PIXMAN_FILTER_NEAREST : PIXMAN_FILTER_BILINEAR, NULL, 0);
+	// Behave like GL_CLAMP_TO_EDGE when the image fills its box
+	pixman_image_set_repeat(src,
+		(axis_aligned || pixel_aligned) ? PIXMAN_REPEAT_PAD : PIXMAN_REPEAT_NONE);
+
+	pixman_image_composite32(PIXMAN_OP_OVER, src, mask, renderer->image,
+		box.x1, box.y1, 0, 0, box.x1, box.y1,
+		box.x2 - box.x1, box.y2 - box.y1);
+
+	// The image may be shared, restore its state
+	pixman_image_set_transform(src, NULL);
+	pixman_image_set_filter(src, PIXMAN_FILTER_NEAREST, NULL, 0);
+	pixman_image_set_repeat(src, PIXMAN_REPEAT_NONE);
+	return true;
+}
+
+/**
+ * Fills a convex polygon given in unit square coordinates.
+ */
+static void render_polygon(struct wlr_pixman_renderer *renderer,
+		const pixman_color_t *color, const struct pixman_f_transform *tr,
+		const double points[][2], size_t points_len) {
+	assert(points_len >= 3 && points_len <= POLYGON_MAX_POINTS);
+	size_t triangles_len = points_len - 2;
+	pixman_triangle_t triangles[POLYGON_MAX_POINTS - 2];
+
+	pixman_point_fixed_t fixed[POLYGON_MAX_POINTS];
+	for (size_t i = 0; i < points_len; ++i) {
+		double x, y;
+		transform_point(tr, points[i][0], points[i][1], &x, &y);
+		fixed[i].x = pixman_double_to_fixed(x);
+		fixed[i].y = pixman_double_to_fixed(y);
+	}
+	for (size_t i = 0; i < triangles_len; ++i) {
+		triangles[i].p1 = fixed[0];
+		triangles[i].p2 = fixed[i + 1];
+		triangles[i].p3 = fixed[i + 2];
+	}
+
+	pixman_image_t *src = pixman_image_create_solid_fill(color);
+	pixman_composite_triangles(PIXMAN_OP_OVER, src, renderer->image,
+		PIXMAN_a8, 0, 0, 0, 0, triangles_len, triangles);
+	pixman_image_unref(src);
+}
+
+static void pixman_begin(struct wlr_renderer *wlr_renderer, uint32_t width,
+		uint32_t height) {
+	struct wlr_pixman_renderer *renderer =
+		pixman_get_renderer_in_context(wlr_renderer);
+	renderer->width = width;
+	renderer->height = height;
+	pixman_image_set_clip_region32(renderer->image, NULL);
+}
+
+static void pixman_clear(struct wlr_renderer *wlr_renderer,
+		const float color[static 4]) {
+	struct wlr_pixman_renderer *renderer =
+		pixman_get_renderer_in_context(wlr_renderer);
+
+	pixman_color_t pixman_color;
+	color_to_pixman(color, &pixman_color);
+	pixman_box32_t box = {
+		.x2 = renderer->width,
+		.y2 = renderer->height,
+	};
+	pixman_image_fill_boxes(PIXMAN_OP_SRC, renderer->image, &pixman_color,
+		1, &box);
+}
+
+static void pixman_scissor(struct wlr_renderer *wlr_renderer,
+		struct wlr_box *box) {
+	struct wlr_pixman_renderer *renderer =
+		pixman_get_renderer_in_context(wlr_renderer);
+
+	if (box == NULL) {
+		pixman_image_set_clip_region32(renderer->image, NULL);
+		return;
+	}
+
+	pixman_region32_t region;
+	pixman_region32_init_rect(&region, box->x, box->y,
+		box->width, box->height);
+	pixman_image_set_clip_region32(renderer->image, &region);
+	pixman_region32_fini(&region);
+}
+
+static bool pixman_render_texture_with_matrix(
+		struct wlr_renderer *wlr_renderer, struct wlr_texture *wlr_texture,
+		const float matrix[static 9], float alpha) {
+	struct wlr_pixman_renderer *renderer =
+		pixman_get_renderer_in_context(wlr_renderer);
+	struct wlr_pixman_texture *texture = pixman_get_texture(wlr_texture);
+
+	pixman_image_t *image = pixman_texture_begin_access(texture);
+	if (image == NULL) {
+		pixman_texture_end_access(texture);
+		return false;
+	}
+
+	pixman_image_t *mask = NULL;
+	if (alpha < 1.0) {
+		pixman_color_t mask_color = { .alpha = alpha * 0xFFFF };
+		mask = pixman_image_create_solid_fill(&mask_color);
+	}
+
+	bool ok = render_image(renderer, image, texture->width, texture->height,
+		matrix, mask);
+
+	if (mask != NULL) {
+		pixman_image_unref(mask);
+	}
+	pixman_texture_end_access(texture);
+	return ok;
+}
+
+static void pixman_render_quad_with_matrix(struct wlr_renderer *wlr_renderer,
+		const float color[static 4], const float matrix[static 9]) {
+	struct wlr_pixman_renderer *renderer =
+		pixman_get_renderer_in_context(wlr_renderer);
+
+	pixman_color_t pixman_color;
+	color_to_pixman(color, &pixman_color);
+
+	struct pixman_f_transform tr;
+	get_pixel_transform(renderer, matrix, 1, 1, &tr);
+
+	if (tr.m[0][1] == 0 && tr.m[1][0] == 0) {
+		pixman_box32_t box;
+		if (get_dst_box(renderer, &tr, 1, 1, &box)) {
+			pixman_image_fill_boxes(PIXMAN_OP_OVER, renderer->image,
+				&pixman_color, 1, &box);
+		}
+		return;
+	}
+
+	static const double corners[4][2] = {
+		{ 0, 0 },
+		{ 1, 0 },
+		{ 1, 1 },
+		{ 0, 1 },
+	};
+	render_polygon(renderer, &pixman_color, &tr, corners, 4);
+}
+
+static void pixman_render_ellipse_with_matrix(struct wlr_renderer *wlr_renderer,
+		const float color[static 4], const float matrix[static 9]) {
+	struct wlr_pixman_renderer *renderer =
+		pixman_get_renderer_in_context(wlr_renderer);
+
+	pixman_color_t pixman_color;
+	color_to_pixman(color, &pixman_color);
+
+	struct pixman_f_transform tr;
+	get_pixel_transform(renderer, matrix, 1, 1, &tr);
+
+	double points[ELLIPSE_SEGMENTS][2];
+	for (size_t i = 0; i < ELLIPSE_SEGMENTS; ++i) {
+		double angle = 2 * M_PI * i / ELLIPSE_SEGMENTS;
+		points[i][0] = 0.5 + 0.5 * cos(angle);
+		points[i][1] = 0.5 + 0.5 * sin(angle);
+	}
+	render_polygon(renderer, &pixman_color, &tr, points, ELLIPSE_SEGMENTS);
+}
+
+static const enum wl_shm_format *pixman_renderer_formats(
+		struct wlr_renderer *wlr_renderer, size_t *len) {
+	return get_pixman_wl_formats(len);
+}
+
+static bool pixman_format_supported(struct wlr_renderer *wlr_renderer,
+		enum wl_shm_format wl_fmt) {
+	return get_pixman_format_from_wl(wl_fmt) != NULL;
+}
+
+static pixman_image_t *begin_read(struct wlr_pixman_renderer *renderer) {
+	if (renderer->read_buffer != NULL) {
+		return pixman_texture_begin_access(
+			pixman_get_texture(renderer->read_buffer->texture));
+	}
+	return renderer->image;
+}
+
+static void end_read(struct wlr_pixman_renderer *renderer) {
+	if (renderer->read_buffer != NULL) {
+		pixman_texture_end_access(
+			pixman_get_texture(renderer->read_buffer->texture));
+	}
+}
+
+static enum wl_shm_format pixman_preferred_read_format(
+		struct wlr_renderer *wlr_renderer) {
+	struct wlr_pixman_renderer *renderer = pixman_get_renderer(wlr_renderer);
+
+	const struct wlr_pixman_pixel_format *fmt = NULL;
+	pixman_image_t *image = begin_read(renderer);
+	if (image != NULL) {
+		fmt = get_pixman_format_from_pixman(pixman_image_get_format(image));
+	}
+	end_read(renderer);
+
+	return fmt != NULL ? fmt->wl_format : WL_SHM_FORMAT_XRGB8888;
+}
+
+static bool read_image_pixels(pixman_image_t *src,
+		const struct wlr_pixman_pixel_format *fmt, uint32_t stride,
+		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
+		uint32_t dst_x, uint32_t dst_y, void *data) {
+	if (pixman_image_get_format(src) == fmt->pixman_format) {
+		// Same format, the rows can be copied as is
+		int bytes_per_pixel = fmt->bpp / 8;
+		int src_stride = pixman_image_get_stride(src);
+		const uint8_t *src_data = (const uint8_t *)pixman_image_get_data(src) +
+			src_y * src_stride + src_x * bytes_per_pixel;
+		uint8_t *dst_data = (uint8_t *)data +
+			dst_y * stride + dst_x * bytes_per_pixel;
+		for (uint32_t i = 0; i < height; ++i) {
+			memcpy(dst_data + i * stride, src_data + i * src_stride,
+				width * bytes_per_pixel);
+		}
+		return true;
+	}
+
+	pixman_image_t *dst = pixman_image_create_bits_no_clear(fmt->pixman_format,
+		dst_x + width, dst_y + height, data, stride);
+	if (dst == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create pixman image");
+		return false;
+	}
+	pixman_image_composite32(PIXMAN_OP_SRC, src, NULL, dst,
+		src_x, src_y, 0, 0, dst_x, dst_y, width, height);
+	pixman_image_unref(dst);
+	return true;
+}
+
+static bool pixman_read_pixels(struct wlr_renderer *wlr_renderer,
+		enum wl_shm_format wl_fmt, uint32_t *flags, uint32_t stride,
+		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
+		uint32_t dst_x, uint32_t dst_y, void *data) {
+	struct wlr_pixman_renderer *renderer = pixman_get_renderer(wlr_renderer);
+
+	const struct wlr_pixman_pixel_format *fmt =
+		get_pixman_format_from_wl(wl_fmt);
+	if (fmt == NULL) {
+		wlr_log(WLR_ERROR, "Cannot read pixels: unsupported pixel format");
+		return false;
+	}
+
+	pixman_image_t *src = begin_read(renderer);
+	bool ok = src != NULL;
+	if (!ok) {
+		wlr_log(WLR_ERROR, "Cannot read pixels: no image bound");
+	} else {
+		ok = read_image_pixels(src, fmt, stride, width, height,
+			src_x, src_y, dst_x, dst_y, data);
+	}
+	end_read(renderer);
+
+	if (flags != NULL) {
+		*flags = 0;
+	}
+	return ok;
+}
+
+static bool pixman_bind_buffer(struct wlr_renderer *wlr_renderer,
+		struct wlr_buffer *buffer) {
+	struct wlr_pixman_renderer *renderer = pixman_get_renderer(wlr_renderer);
+
+	wlr_buffer_unref(renderer->read_buffer);
+	renderer->read_buffer = NULL;
+	if (buffer == NULL) {
+		return true;
+	}
+
+	if (buffer->texture == NULL || !wlr_texture_is_pixman(buffer->texture)) {
+		wlr_log(WLR_DEBUG, "Cannot bind buffer: not a pixman texture");
+		return false;
+	}
+	renderer->read_buffer = wlr_buffer_ref(buffer);
+	return true;
+}
+
+static struct wlr_texture *pixman_texture_from_pixels_impl(
+		struct wlr_renderer *wlr_renderer, enum wl_shm_format wl_fmt,
+		uint32_t stride, uint32_t width, uint32_t height, const void *data) {
+	return pixman_texture_from_pixels(wl_fmt, stride, width, height, data);
+}
+
+static struct wlr_texture *pixman_texture_from_wl_shm_impl(
+		struct wlr_renderer *wlr_renderer, struct wl_resource *resource) {
+	return pixman_texture_from_wl_shm(resource);
+}
+
+static void pixman_destroy(struct wlr_renderer *wlr_renderer) {
+	struct wlr_pixman_renderer *renderer = pixman_get_renderer(wlr_renderer);
+	wlr_buffer_unref(renderer->read_buffer);
+	if (renderer->image != NULL) {
+		pixman_image_unref(renderer->image);
+	}
+	free(renderer);
+}
+
+static const struct wlr_renderer_impl renderer_impl = {
+	.begin = pixman_begin,
+	.clear = pixman_clear,
+	.scissor = pixman_scissor,
+	.render_texture_with_matrix = pixman_render_texture_with_matrix,
+	.render_quad_with_matrix = pixman_render_quad_with_matrix,
+	.render_ellipse_with_matrix = pixman_render_ellipse_with_matrix,
+	.formats = pixman_renderer_formats,
+	.format_supported = pixman_format_supported,
+	.preferred_read_format = pixman_preferred_read_format,
+	.read_pixels = pixman_read_pixels,
+	.bind_buffer = pixman_bind_buffer,
+	.texture_from_pixels = pixman_texture_from_pixels_impl,
+	.texture_from_wl_shm = pixman_texture_from_wl_shm_impl,
+	.destroy = pixman_destroy,
+};
+
+struct wlr_renderer *wlr_pixman_renderer_create(void) {
+	struct wlr_pixman_renderer *renderer =
+		calloc(1, sizeof(struct wlr_pixman_renderer));
+	if (renderer == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+
+	wlr_log(WLR_INFO, "Creating pixman renderer");
+	wlr_renderer_init(&renderer->wlr_renderer, &renderer_impl);
+	return &renderer->wlr_renderer;
+}
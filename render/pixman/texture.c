@@ -0,0 +1,229 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlr/util/log.h>
+#include "render/pixman.h"
+
+static const struct wlr_texture_impl texture_impl;
+
+bool wlr_texture_is_pixman(struct wlr_texture *wlr_texture) {
+	return wlr_texture->impl == &texture_impl;
+}
+
+struct wlr_pixman_texture *pixman_get_texture(
+		struct wlr_texture *wlr_texture) {
+	assert(wlr_texture_is_pixman(wlr_texture));
+	return (struct wlr_pixman_texture *)wlr_texture;
+}
+
+pixman_image_t *wlr_pixman_texture_get_image(struct wlr_texture *wlr_texture) {
+	struct wlr_pixman_texture *texture = pixman_get_texture(wlr_texture);
+	return texture->image;
+}
+
+static void pixman_texture_get_size(struct wlr_texture *wlr_texture, int *width,
+		int *height) {
+	struct wlr_pixman_texture *texture = pixman_get_texture(wlr_texture);
+	*width = texture->width;
+	*height = texture->height;
+}
+
+static bool pixman_texture_is_opaque(struct wlr_texture *wlr_texture) {
+	struct wlr_pixman_texture *texture = pixman_get_texture(wlr_texture);
+	return !texture->format->has_alpha;
+}
+
+static bool pixman_texture_write_pixels(struct wlr_texture *wlr_texture,
+		uint32_t stride, uint32_t width, uint32_t height,
+		uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y,
+		const void *data) {
+	struct wlr_pixman_texture *texture = pixman_get_texture(wlr_texture);
+
+	if (!texture->writable) {
+		wlr_log(WLR_ERROR, "Cannot write pixels to immutable texture");
+		return false;
+	}
+
+	int bytes_per_pixel = texture->format->bpp / 8;
+	int dst_stride = pixman_image_get_stride(texture->image);
+	uint8_t *dst = (uint8_t *)pixman_image_get_data(texture->image) +
+		dst_y * dst_stride + dst_x * bytes_per_pixel;
+	const uint8_t *src = (const uint8_t *)data +
+		src_y * stride + src_x * bytes_per_pixel;
+	for (uint32_t i = 0; i < height; ++i) {
+		memcpy(dst + i * dst_stride, src + i * stride,
+			width * bytes_per_pixel);
+	}
+	return true;
+}
+
+static void pixman_texture_destroy(struct wlr_texture *wlr_texture) {
+	if (wlr_texture == NULL) {
+		return;
+	}
+
+	struct wlr_pixman_texture *texture = pixman_get_texture(wlr_texture);
+	if (texture->shm_buffer != NULL) {
+		wl_list_remove(&texture->buffer_destroy.link);
+	}
+	if (texture->image != NULL) {
+		pixman_image_unref(texture->image);
+	}
+	free(texture->data);
+	free(texture);
+}
+
+static const struct wlr_texture_impl texture_impl = {
+	.get_size = pixman_texture_get_size,
+	.is_opaque = pixman_texture_is_opaque,
+	.write_pixels = pixman_texture_write_pixels,
+	.destroy = pixman_texture_destroy,
+};
+
+static struct wlr_pixman_texture *texture_create(
+		const struct wlr_pixman_pixel_format *fmt, int width, int height) {
+	struct wlr_pixman_texture *texture =
+		calloc(1, sizeof(struct wlr_pixman_texture));
+	if (texture == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	wlr_texture_init(&texture->wlr_texture, &texture_impl);
+	texture->format = fmt;
+	texture->width = width;
+	texture->height = height;
+	return texture;
+}
+
+struct wlr_texture *pixman_texture_from_pixels(enum wl_shm_format wl_fmt,
+		uint32_t stride, uint32_t width, uint32_t height, const void *data) {
+	const struct wlr_pixman_pixel_format *fmt =
+		get_pixman_format_from_wl(wl_fmt);
+	if (fmt == NULL) {
+		wlr_log(WLR_ERROR, "Unsupported pixel format %"PRIu32, wl_fmt);
+		return NULL;
+	}
+
+	struct wlr_pixman_texture *texture = texture_create(fmt, width, height);
+	if (texture == NULL) {
+		return NULL;
+	}
+	texture->writable = true;
+
+	// pixman requires the stride to be a multiple of 4 bytes
+	int image_stride = ((width * fmt->bpp / 8) + 3) & ~3;
+	texture->data = malloc((size_t)image_stride * height);
+	if (texture->data == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		free(texture);
+		return NULL;
+	}
+
+	texture->image = pixman_image_create_bits_no_clear(fmt->pixman_format,
+		width, height, texture->data, image_stride);
+	if (texture->image == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create pixman image");
+		free(texture->data);
+		free(texture);
+		return NULL;
+	}
+
+	pixman_texture_write_pixels(&texture->wlr_texture, stride, width, height,
+		0, 0, 0, 0, data);
+	return &texture->wlr_texture;
+}
+
+static void texture_handle_buffer_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_pixman_texture *texture =
+		wl_container_of(listener, texture, buffer_destroy);
+	struct wl_shm_buffer *shm_buffer = texture->shm_buffer;
+	wl_list_remove(&texture->buffer_destroy.link);
+	texture->shm_buffer = NULL;
+
+	// The texture may still be displayed, keep a copy of its last contents
+	if (texture->image != NULL) {
+		pixman_image_unref(texture->image);
+		texture->image = NULL;
+	}
+
+	int32_t stride = wl_shm_buffer_get_stride(shm_buffer);
+	texture->data = malloc((size_t)stride * texture->height);
+	if (texture->data == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return;
+	}
+
+	wl_shm_buffer_begin_access(shm_buffer);
+	memcpy(texture->data, wl_shm_buffer_get_data(shm_buffer),
+		(size_t)stride * texture->height);
+	wl_shm_buffer_end_access(shm_buffer);
+
+	texture->image = pixman_image_create_bits_no_clear(
+		texture->format->pixman_format, texture->width, texture->height,
+		texture->data, stride);
+}
+
+struct wlr_texture *pixman_texture_from_wl_shm(struct wl_resource *resource) {
+	struct wl_shm_buffer *shm_buffer = wl_shm_buffer_get(resource);
+	if (shm_buffer == NULL) {
+		return NULL;
+	}
+
+	enum wl_shm_format wl_fmt = wl_shm_buffer_get_format(shm_buffer);
+	const struct wlr_pixman_pixel_format *fmt =
+		get_pixman_format_from_wl(wl_fmt);
+	if (fmt == NULL) {
+		wlr_log(WLR_ERROR, "Unsupported pixel format %"PRIu32, wl_fmt);
+		return NULL;
+	}
+
+	if (wl_shm_buffer_get_stride(shm_buffer) % 4 != 0) {
+		// pixman can't wrap this buffer, the caller will copy it
+		return NULL;
+	}
+
+	struct wlr_pixman_texture *texture = texture_create(fmt,
+		wl_shm_buffer_get_width(shm_buffer),
+		wl_shm_buffer_get_height(shm_buffer));
+	if (texture == NULL) {
+		return NULL;
+	}
+
+	// The image is created when the texture is first accessed
+	texture->shm_buffer = shm_buffer;
+	wl_resource_add_destroy_listener(resource, &texture->buffer_destroy);
+	texture->buffer_destroy.notify = texture_handle_buffer_destroy;
+
+	return &texture->wlr_texture;
+}
+
+pixman_image_t *pixman_texture_begin_access(
+		struct wlr_pixman_texture *texture) {
+	if (texture->shm_buffer == NULL) {
+		return texture->image;
+	}
+
+	wl_shm_buffer_begin_access(texture->shm_buffer);
+
+	// The client may have resized the pool, which can move its mapping
+	void *data = wl_shm_buffer_get_data(texture->shm_buffer);
+	if (texture->image != NULL &&
+			(void *)pixman_image_get_data(texture->image) != data) {
+		pixman_image_unref(texture->image);
+		texture->image = NULL;
+	}
+	if (texture->image == NULL) {
+		texture->image = pixman_image_create_bits_no_clear(
+			texture->format->pixman_format, texture->width, texture->height,
+			data, wl_shm_buffer_get_stride(texture->shm_buffer));
+	}
+	return texture->image;
+}
+
+void pixman_texture_end_access(struct wlr_pixman_texture *texture) {
+	if (texture->shm_buffer != NULL) {
+		wl_shm_buffer_end_access(texture->shm_buffer);
+	}
+}
@@ -142,11 +142,49 @@ bool wlr_renderer_read_pixels(struct wlr_renderer *r, enum wl_shm_format fmt,
 		src_x, src_y, dst_x, dst_y, data);
 }
 
+bool wlr_renderer_copy_to_dmabuf(struct wlr_renderer *r,
+		struct wlr_dmabuf_attributes *dst, uint32_t *flags,
+		pixman_region32_t *region, int32_t src_x, int32_t src_y) {
+	if (!r->impl->copy_to_dmabuf) {
+		return false;
+	}
+	return r->impl->copy_to_dmabuf(r, dst, flags, region, src_x, src_y);
+}
+
+bool wlr_renderer_bind_buffer(struct wlr_renderer *r,
+		struct wlr_buffer *buffer) {
+	if (!r->impl->bind_buffer) {
+		return false;
+	}
+	return r->impl->bind_buffer(r, buffer);
+}
+
 bool wlr_renderer_format_supported(struct wlr_renderer *r,
 		enum wl_shm_format fmt) {
 	return r->impl->format_supported(r, fmt);
 }
 
+bool wlr_renderer_wait_fence_supported(struct wlr_renderer *r) {
+	if (!r->impl->wait_fence_supported || !r->impl->wait_fence) {
+		return false;
+	}
+	return r->impl->wait_fence_supported(r);
+}
+
+bool wlr_renderer_wait_fence(struct wlr_renderer *r, int fence_fd) {
+	if (!r->impl->wait_fence) {
+		return false;
+	}
+	return r->impl->wait_fence(r, fence_fd);
+}
+
+int wlr_renderer_export_fence(struct wlr_renderer *r) {
+	if (!r->impl->export_fence) {
+		return -1;
+	}
+	return r->impl->export_fence(r);
+}
+
 void wlr_renderer_init_wl_display(struct wlr_renderer *r,
 		struct wl_display *wl_display) {
 	if (wl_display_init_shm(wl_display)) {
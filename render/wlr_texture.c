@@ -26,6 +26,14 @@ struct wlr_texture *wlr_texture_from_pixels(struct wlr_renderer *renderer,
 		height, data);
 }
 
+struct wlr_texture *wlr_texture_from_wl_shm(struct wlr_renderer *renderer,
+		struct wl_resource *buffer) {
+	if (!renderer->impl->texture_from_wl_shm) {
+		return NULL;
+	}
+	return renderer->impl->texture_from_wl_shm(renderer, buffer);
+}
+
 struct wlr_texture *wlr_texture_from_wl_drm(struct wlr_renderer *renderer,
 		struct wl_resource *data) {
 	if (!renderer->impl->texture_from_wl_drm) {
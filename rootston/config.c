@@ -361,6 +361,15 @@ static int config_ini_handler(void *user, const char *section, const char *name,
 			} else {
 				wlr_log(WLR_ERROR, "got invalid output enable value: %s", value);
 			}
+		} else if (strcmp(name, "adaptive-sync") == 0) {
+			if (strcasecmp(value, "true") == 0) {
+				oc->adaptive_sync = true;
+			} else if (strcasecmp(value, "false") == 0) {
+				oc->adaptive_sync = false;
+			} else {
+				wlr_log(WLR_ERROR, "got invalid output adaptive-sync value: %s",
+					value);
+			}
 		} else if (strcmp(name, "x") == 0) {
 			oc->x = strtol(value, NULL, 10);
 		} else if (strcmp(name, "y") == 0) {
@@ -478,6 +487,81 @@ static int config_ini_handler(void *user, const char *section, const char *name,
 	return 1;
 }
 
+uint32_t roots_binding_keysym_hash(xkb_keysym_t keysym) {
+	// Mix the bits so that sums of hashes don't collide for nearby keysyms
+	uint32_t h = keysym;
+	h ^= h >> 16;
+	h *= 0x7feb352d;
+	h ^= h >> 15;
+	h *= 0x846ca68b;
+	h ^= h >> 16;
+	return h;
+}
+
+static uint32_t binding_hash(uint32_t modifiers, uint32_t keysyms_hash) {
+	return keysyms_hash ^ (modifiers * 0x9e3779b1);
+}
+
+static void build_binding_table(struct roots_config *config) {
+	size_t n = wl_list_length(&config->bindings);
+	size_t len = 1;
+	while (len < 2 * n) {
+		len *= 2;
+	}
+
+	config->binding_table = calloc(len, sizeof(*config->binding_table));
+	if (config->binding_table == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate binding table");
+		exit(1);
+	}
+	config->binding_table_len = len;
+
+	// Bindings added last take precedence, they are at the head of the list.
+	// Walk the list backwards so that they end up at the head of buckets.
+	struct roots_binding_config *bc;
+	wl_list_for_each_reverse(bc, &config->bindings, link) {
+		uint32_t keysyms_hash = 0;
+		for (size_t i = 0; i < bc->keysyms_len; ++i) {
+			keysyms_hash += roots_binding_keysym_hash(bc->keysyms[i]);
+		}
+		bc->hash = binding_hash(bc->modifiers, keysyms_hash);
+
+		struct roots_binding_config **bucket =
+			&config->binding_table[bc->hash & (len - 1)];
+		bc->next = *bucket;
+		*bucket = bc;
+	}
+}
+
+struct roots_binding_config *roots_config_get_binding(
+		struct roots_config *config, uint32_t modifiers,
+		const xkb_keysym_t *keysyms, size_t keysyms_len, uint32_t keysyms_hash) {
+	uint32_t hash = binding_hash(modifiers, keysyms_hash);
+	struct roots_binding_config *bc =
+		config->binding_table[hash & (config->binding_table_len - 1)];
+	for (; bc != NULL; bc = bc->next) {
+		if (bc->hash != hash || bc->modifiers != modifiers ||
+				bc->keysyms_len != keysyms_len) {
+			continue;
+		}
+
+		bool ok = true;
+		for (size_t i = 0; i < bc->keysyms_len && ok; ++i) {
+			ok = false;
+			for (size_t j = 0; j < keysyms_len; ++j) {
+				if (keysyms[j] == bc->keysyms[i]) {
+					ok = true;
+					break;
+				}
+			}
+		}
+		if (ok) {
+			return bc;
+		}
+	}
+	return NULL;
+}
+
 struct roots_config *roots_config_create_from_args(int argc, char *argv[]) {
 	struct roots_config *config = calloc(1, sizeof(struct roots_config));
 	if (config == NULL) {
@@ -556,6 +640,8 @@ struct roots_config *roots_config_create_from_args(int argc, char *argv[]) {
 		exit(1);
 	}
 
+	build_binding_table(config);
+
 	return config;
 }
 
@@ -606,6 +692,7 @@ void roots_config_destroy(struct roots_config *config) {
 		free(bc->command);
 		free(bc);
 	}
+	free(config->binding_table);
 
 	free(config->config_path);
 	free(config);
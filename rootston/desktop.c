@@ -426,6 +426,12 @@ struct roots_desktop *desktop_create(struct roots_server *server,
 
 	desktop->presentation =
 		wlr_presentation_create(server->wl_display, server->backend);
+	desktop->explicit_synchronization =
+		wlr_linux_explicit_synchronization_v1_create(server->wl_display,
+		server->renderer);
+	if (desktop->explicit_synchronization == NULL) {
+		wlr_log(WLR_DEBUG, "Explicit synchronization unavailable");
+	}
 	desktop->foreign_toplevel_manager_v1 =
 		wlr_foreign_toplevel_manager_v1_create(server->wl_display);
 	desktop->relative_pointer_manager =
@@ -75,8 +75,10 @@ static void handle_new_input(struct wl_listener *listener, void *data) {
 
 		wlr_log(WLR_DEBUG, "input has config, tap_enabled: %d\n", dc->tap_enabled);
 		if (dc->tap_enabled) {
+			wlr_libinput_device_acquire(device);
 			libinput_device_config_tap_set_enabled(libinput_dev,
 					LIBINPUT_CONFIG_TAP_ENABLED);
+			wlr_libinput_device_release(device);
 		}
 	}
 }
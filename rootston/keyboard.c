@@ -14,43 +14,35 @@
 #include "rootston/keyboard.h"
 #include "rootston/seat.h"
 
-static ssize_t pressed_keysyms_index(xkb_keysym_t *pressed_keysyms,
+static ssize_t pressed_keysyms_index(struct roots_pressed_keysyms *pressed,
 		xkb_keysym_t keysym) {
-	for (size_t i = 0; i < ROOTS_KEYBOARD_PRESSED_KEYSYMS_CAP; ++i) {
-		if (pressed_keysyms[i] == keysym) {
+	for (size_t i = 0; i < pressed->len; ++i) {
+		if (pressed->keysyms[i] == keysym) {
 			return i;
 		}
 	}
 	return -1;
 }
 
-static size_t pressed_keysyms_length(xkb_keysym_t *pressed_keysyms) {
-	size_t n = 0;
-	for (size_t i = 0; i < ROOTS_KEYBOARD_PRESSED_KEYSYMS_CAP; ++i) {
-		if (pressed_keysyms[i] != XKB_KEY_NoSymbol) {
-			++n;
-		}
-	}
-	return n;
-}
-
-static void pressed_keysyms_add(xkb_keysym_t *pressed_keysyms,
+static void pressed_keysyms_add(struct roots_pressed_keysyms *pressed,
 		xkb_keysym_t keysym) {
-	ssize_t i = pressed_keysyms_index(pressed_keysyms, keysym);
-	if (i < 0) {
-		i = pressed_keysyms_index(pressed_keysyms, XKB_KEY_NoSymbol);
-		if (i >= 0) {
-			pressed_keysyms[i] = keysym;
-		}
+	if (keysym == XKB_KEY_NoSymbol ||
+			pressed->len == ROOTS_KEYBOARD_PRESSED_KEYSYMS_CAP ||
+			pressed_keysyms_index(pressed, keysym) >= 0) {
+		return;
 	}
+	pressed->keysyms[pressed->len++] = keysym;
+	pressed->hash += roots_binding_keysym_hash(keysym);
 }
 
-static void pressed_keysyms_remove(xkb_keysym_t *pressed_keysyms,
+static void pressed_keysyms_remove(struct roots_pressed_keysyms *pressed,
 		xkb_keysym_t keysym) {
-	ssize_t i = pressed_keysyms_index(pressed_keysyms, keysym);
-	if (i >= 0) {
-		pressed_keysyms[i] = XKB_KEY_NoSymbol;
+	ssize_t i = pressed_keysyms_index(pressed, keysym);
+	if (i < 0) {
+		return;
 	}
+	pressed->keysyms[i] = pressed->keysyms[--pressed->len];
+	pressed->hash -= roots_binding_keysym_hash(keysym);
 }
 
 static bool keysym_is_modifier(xkb_keysym_t keysym) {
@@ -69,7 +61,7 @@ static bool keysym_is_modifier(xkb_keysym_t keysym) {
 	}
 }
 
-static void pressed_keysyms_update(xkb_keysym_t *pressed_keysyms,
+static void pressed_keysyms_update(struct roots_pressed_keysyms *pressed,
 		const xkb_keysym_t *keysyms, size_t keysyms_len,
 		enum wlr_key_state state) {
 	for (size_t i = 0; i < keysyms_len; ++i) {
@@ -77,9 +69,9 @@ static void pressed_keysyms_update(xkb_keysym_t *pressed_keysyms,
 			continue;
 		}
 		if (state == WLR_KEY_PRESSED) {
-			pressed_keysyms_add(pressed_keysyms, keysyms[i]);
+			pressed_keysyms_add(pressed, keysyms[i]);
 		} else { // WLR_KEY_RELEASED
-			pressed_keysyms_remove(pressed_keysyms, keysyms[i]);
+			pressed_keysyms_remove(pressed, keysyms[i]);
 		}
 	}
 }
@@ -128,7 +120,7 @@ static bool keyboard_execute_compositor_binding(struct roots_keyboard *keyboard,
  * should be propagated to clients.
  */
 static bool keyboard_execute_binding(struct roots_keyboard *keyboard,
-		xkb_keysym_t *pressed_keysyms, uint32_t modifiers,
+		struct roots_pressed_keysyms *pressed, uint32_t modifiers,
 		const xkb_keysym_t *keysyms, size_t keysyms_len) {
 	for (size_t i = 0; i < keysyms_len; ++i) {
 		if (keyboard_execute_compositor_binding(keyboard, keysyms[i])) {
@@ -137,27 +129,12 @@ static bool keyboard_execute_binding(struct roots_keyboard *keyboard,
 	}
 
 	// User-defined bindings
-	size_t n = pressed_keysyms_length(pressed_keysyms);
-	struct wl_list *bindings = &keyboard->input->server->config->bindings;
-	struct roots_binding_config *bc;
-	wl_list_for_each(bc, bindings, link) {
-		if (modifiers ^ bc->modifiers || n != bc->keysyms_len) {
-			continue;
-		}
-
-		bool ok = true;
-		for (size_t i = 0; i < bc->keysyms_len; i++) {
-			ssize_t j = pressed_keysyms_index(pressed_keysyms, bc->keysyms[i]);
-			if (j < 0) {
-				ok = false;
-				break;
-			}
-		}
-
-		if (ok) {
-			keyboard_binding_execute(keyboard, bc->command);
-			return true;
-		}
+	struct roots_binding_config *bc = roots_config_get_binding(
+		keyboard->input->server->config, modifiers, pressed->keysyms,
+		pressed->len, pressed->hash);
+	if (bc != NULL) {
+		keyboard_binding_execute(keyboard, bc->command);
+		return true;
 	}
 
 	return false;
@@ -217,21 +194,21 @@ void roots_keyboard_handle_key(struct roots_keyboard *keyboard,
 
 	keysyms_len = keyboard_keysyms_translated(keyboard, keycode, &keysyms,
 		&modifiers);
-	pressed_keysyms_update(keyboard->pressed_keysyms_translated, keysyms,
+	pressed_keysyms_update(&keyboard->pressed_keysyms_translated, keysyms,
 		keysyms_len, event->state);
 	if (event->state == WLR_KEY_PRESSED) {
 		handled = keyboard_execute_binding(keyboard,
-			keyboard->pressed_keysyms_translated, modifiers, keysyms,
+			&keyboard->pressed_keysyms_translated, modifiers, keysyms,
 			keysyms_len);
 	}
 
 	// Handle raw keysyms
 	keysyms_len = keyboard_keysyms_raw(keyboard, keycode, &keysyms, &modifiers);
-	pressed_keysyms_update(keyboard->pressed_keysyms_raw, keysyms, keysyms_len,
+	pressed_keysyms_update(&keyboard->pressed_keysyms_raw, keysyms, keysyms_len,
 		event->state);
 	if (event->state == WLR_KEY_PRESSED && !handled) {
 		handled = keyboard_execute_binding(keyboard,
-			keyboard->pressed_keysyms_raw, modifiers, keysyms, keysyms_len);
+			&keyboard->pressed_keysyms_raw, modifiers, keysyms, keysyms_len);
 	}
 
 	if (!handled) {
@@ -7,7 +7,6 @@
 #include <wlr/config.h>
 #include <wlr/types/wlr_compositor.h>
 #include <wlr/types/wlr_output_layout.h>
-#include <wlr/types/wlr_presentation_time.h>
 #include <wlr/types/wlr_xdg_shell_v6.h>
 #include <wlr/types/wlr_xdg_shell.h>
 #include <wlr/util/log.h>
@@ -43,6 +42,7 @@ struct surface_iterator_data {
 
 	struct roots_output *output;
 	double ox, oy;
+	int sx, sy; // offset of the iterated surface tree in the view
 	int width, height;
 	float rotation;
 };
@@ -59,8 +59,8 @@ static bool get_surface_box(struct surface_iterator_data *data,
 	int sw = surface->current.width;
 	int sh = surface->current.height;
 
-	double _sx = sx + surface->sx;
-	double _sy = sy + surface->sy;
+	double _sx = data->sx + sx + surface->sx;
+	double _sy = data->sy + sy + surface->sy;
 	rotate_child_position(&_sx, &_sy, sw, sh, data->width, data->height,
 		data->rotation);
 
@@ -352,7 +352,11 @@ static void damage_surface_iterator(struct roots_output *output,
 		wlr_output_damage_add_box(output->damage, &box);
 	}
 
-	wlr_output_schedule_frame(output->wlr_output);
+	// A commit without damage still needs a frame to send its frame
+	// callbacks, but only on the outputs displaying the surface
+	if (!*whole && !wl_list_empty(&surface->current.frame_callback_list)) {
+		wlr_output_schedule_frame(output->wlr_output);
+	}
 }
 
 void output_damage_whole_local_surface(struct roots_output *output,
@@ -402,14 +406,36 @@ void output_damage_from_local_surface(struct roots_output *output,
 		damage_surface_iterator, &whole);
 }
 
-void output_damage_from_view(struct roots_output *output,
-		struct roots_view *view) {
+void output_damage_from_view_surface(struct roots_output *output,
+		struct roots_view *view, struct wlr_surface *surface, int sx, int sy) {
 	if (!view_accept_damage(output, view)) {
 		return;
 	}
 
+	struct wlr_box *output_box =
+		wlr_output_layout_get_box(output->desktop->layout, output->wlr_output);
+	if (!output_box) {
+		return;
+	}
+
 	bool whole = false;
-	output_view_for_each_surface(output, view, damage_surface_iterator, &whole);
+	struct surface_iterator_data data = {
+		.user_iterator = damage_surface_iterator,
+		.user_data = &whole,
+		.output = output,
+		.ox = view->box.x - output_box->x,
+		.oy = view->box.y - output_box->y,
+		.sx = sx,
+		.sy = sy,
+		.width = view->box.width,
+		.height = view->box.height,
+		.rotation = view->rotation,
+	};
+
+	// Sub-surfaces are included because re-ordering them damages them when
+	// the parent commits
+	wlr_surface_for_each_surface(surface,
+		output_for_each_surface_iterator, &data);
 }
 
 static void set_mode(struct wlr_output *output,
@@ -526,9 +552,9 @@ static void output_destroy(struct roots_output *output) {
 	wl_list_remove(&output->enable.link);
 	wl_list_remove(&output->mode.link);
 	wl_list_remove(&output->transform.link);
-	wl_list_remove(&output->present.link);
 	wl_list_remove(&output->damage_frame.link);
 	wl_list_remove(&output->damage_destroy.link);
+	wl_event_source_remove(output->frame_done_timer);
 	free(output);
 }
 
@@ -558,6 +584,13 @@ static void output_damage_handle_destroy(struct wl_listener *listener,
 	output_destroy(output);
 }
 
+static int output_handle_frame_done_timer(void *data) {
+	struct roots_output *output = data;
+	// Frame done events are sent after rendering, even if nothing changed
+	wlr_output_schedule_frame(output->wlr_output);
+	return 0;
+}
+
 static void output_handle_mode(struct wl_listener *listener, void *data) {
 	struct roots_output *output =
 		wl_container_of(listener, output, mode);
@@ -571,32 +604,6 @@ static void output_handle_transform(struct wl_listener *listener, void *data) {
 	arrange_layers(output);
 }
 
-static void surface_send_presented_iterator(struct roots_output *output,
-		struct wlr_surface *surface, struct wlr_box *_box, float rotation,
-		void *data) {
-	struct wlr_presentation_event *event = data;
-	wlr_presentation_send_surface_presented(output->desktop->presentation,
-		surface, event);
-}
-
-static void output_handle_present(struct wl_listener *listener, void *data) {
-	struct roots_output *output =
-		wl_container_of(listener, output, present);
-	struct wlr_output_event_present *output_event = data;
-
-	struct wlr_presentation_event event = {
-		.output = output->wlr_output,
-		.tv_sec = (uint64_t)output_event->when->tv_sec,
-		.tv_nsec = (uint32_t)output_event->when->tv_nsec,
-		.refresh = (uint32_t)output_event->refresh,
-		.seq = (uint64_t)output_event->seq,
-		.flags = output_event->flags,
-	};
-
-	output_for_each_surface(output,
-		surface_send_presented_iterator, &event);
-}
-
 void handle_new_output(struct wl_listener *listener, void *data) {
 	struct roots_desktop *desktop = wl_container_of(listener, desktop,
 		new_output);
@@ -618,6 +625,11 @@ void handle_new_output(struct wl_listener *listener, void *data) {
 
 	output->damage = wlr_output_damage_create(wlr_output);
 
+	struct wl_event_loop *event_loop =
+		wl_display_get_event_loop(desktop->server->wl_display);
+	output->frame_done_timer = wl_event_loop_add_timer(event_loop,
+		output_handle_frame_done_timer, output);
+
 	output->destroy.notify = output_handle_destroy;
 	wl_signal_add(&wlr_output->events.destroy, &output->destroy);
 	output->enable.notify = output_handle_enable;
@@ -626,8 +638,6 @@ void handle_new_output(struct wl_listener *listener, void *data) {
 	wl_signal_add(&wlr_output->events.mode, &output->mode);
 	output->transform.notify = output_handle_transform;
 	wl_signal_add(&wlr_output->events.transform, &output->transform);
-	output->present.notify = output_handle_present;
-	wl_signal_add(&wlr_output->events.present, &output->present);
 
 	output->damage_frame.notify = output_damage_handle_frame;
 	wl_signal_add(&output->damage->events.frame, &output->damage_frame);
@@ -663,6 +673,8 @@ void handle_new_output(struct wl_listener *listener, void *data) {
 
 			wlr_output_set_scale(wlr_output, output_config->scale);
 			wlr_output_set_transform(wlr_output, output_config->transform);
+			wlr_output_enable_adaptive_sync(wlr_output,
+				output_config->adaptive_sync);
 			wlr_output_layout_add(desktop->layout, wlr_output, output_config->x,
 				output_config->y);
 		} else {
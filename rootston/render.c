@@ -8,6 +8,7 @@
 #include <wlr/types/wlr_matrix.h>
 #include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_linux_dmabuf_v1.h>
+#include <wlr/types/wlr_presentation_time.h>
 #include <wlr/util/log.h>
 #include <wlr/util/region.h>
 #include "rootston/layers.h"
@@ -87,6 +88,9 @@ static void render_surface_iterator(struct roots_output *output,
 		return;
 	}
 
+	wlr_presentation_surface_sampled_on_output(output->desktop->presentation,
+		surface, wlr_output);
+
 	struct wlr_box box = *_box;
 	scale_box(&box, wlr_output->scale);
 
@@ -244,14 +248,196 @@ static bool scan_out_fullscreen_view(struct roots_output *output) {
 	if (!wlr_output_attach_buffer(wlr_output, surface->buffer)) {
 		return false;
 	}
+
+	wlr_presentation_surface_sampled_on_output(desktop->presentation, surface,
+		wlr_output);
+
 	return wlr_output_commit(wlr_output);
 }
 
-static void surface_send_frame_done_iterator(struct roots_output *output,
+// Surfaces without visible pixels get at most one frame done event per
+// interval, so that they don't render frames nobody will see
+#define OCCLUDED_FRAME_DONE_INTERVAL_MS 1000
+
+struct frame_done_entry {
+	struct wlr_surface *surface;
+	struct wlr_box box; // output-local layout coordinates
+	bool opaque;
+	bool hidden; // not rendered at all, e.g. below a fullscreen view
+};
+
+struct frame_done_data {
+	struct wl_array entries; // struct frame_done_entry, bottom to top
+	float alpha;
+	bool hidden;
+};
+
+static inline int64_t timespec_to_msec(const struct timespec *a) {
+	return (int64_t)a->tv_sec * 1000 + a->tv_nsec / 1000000;
+}
+
+static void collect_surface_iterator(struct roots_output *output,
 		struct wlr_surface *surface, struct wlr_box *box, float rotation,
-		void *data) {
-	struct timespec *when = data;
-	wlr_surface_send_frame_done(surface, when);
+		void *_data) {
+	struct frame_done_data *data = _data;
+
+	struct frame_done_entry *entry =
+		wl_array_add(&data->entries, sizeof(struct frame_done_entry));
+	if (entry == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return;
+	}
+	entry->surface = surface;
+	wlr_box_rotated_bounds(&entry->box, box, rotation);
+	entry->opaque = rotation == 0.0 && data->alpha >= 1.0;
+	entry->hidden = data->hidden;
+}
+
+static void collect_view(struct roots_output *output, struct roots_view *view,
+		struct frame_done_data *data) {
+	if (view->fullscreen_output != NULL && view->fullscreen_output != output) {
+		return;
+	}
+
+	data->alpha = view->alpha;
+	output_view_for_each_surface(output, view, collect_surface_iterator, data);
+	data->alpha = 1.0;
+}
+
+static void collect_layer(struct roots_output *output,
+		enum zwlr_layer_shell_v1_layer layer, struct frame_done_data *data) {
+	output_layer_for_each_surface(output, &output->layers[layer],
+		collect_surface_iterator, data);
+}
+
+/**
+ * Collect the surfaces displayed on the output, in the same order as
+ * output_render draws them. Surfaces hidden by a fullscreen view are collected
+ * below it, so that they are throttled too.
+ */
+static void collect_frame_done_surfaces(struct roots_output *output,
+		struct frame_done_data *data) {
+	struct roots_desktop *desktop = output->desktop;
+
+	if (output->fullscreen_view != NULL) {
+		struct roots_view *view = output->fullscreen_view;
+
+		data->hidden = true;
+		collect_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, data);
+		collect_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM, data);
+		struct roots_view *hidden_view;
+		wl_list_for_each_reverse(hidden_view, &desktop->views, link) {
+			if (hidden_view != view) {
+				collect_view(output, hidden_view, data);
+			}
+		}
+		collect_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_TOP, data);
+		data->hidden = false;
+
+		collect_view(output, view, data);
+#if WLR_HAS_XWAYLAND
+		if (view->type == ROOTS_XWAYLAND_VIEW) {
+			struct roots_xwayland_surface *xwayland_surface =
+				roots_xwayland_surface_from_view(view);
+			output_xwayland_children_for_each_surface(output,
+				xwayland_surface->xwayland_surface,
+				collect_surface_iterator, data);
+		}
+#endif
+	} else {
+		collect_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, data);
+		collect_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM, data);
+
+		struct roots_view *view;
+		wl_list_for_each_reverse(view, &desktop->views, link) {
+			collect_view(output, view, data);
+		}
+
+		collect_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_TOP, data);
+	}
+
+	output_drag_icons_for_each_surface(output, desktop->server->input,
+		collect_surface_iterator, data);
+
+	collect_layer(output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, data);
+}
+
+/**
+ * Send frame done events to the surfaces with visible pixels on the output.
+ * Occluded surfaces, and surfaces hidden by a fullscreen view, are throttled
+ * to OCCLUDED_FRAME_DONE_INTERVAL_MS.
+ */
+static void send_frame_done(struct roots_output *output,
+		struct timespec *when) {
+	struct frame_done_data data = { .alpha = 1.0 };
+	wl_array_init(&data.entries);
+	collect_frame_done_surfaces(output, &data);
+
+	int64_t elapsed = timespec_to_msec(when) -
+		timespec_to_msec(&output->last_occluded_frame_done);
+	bool send_occluded = elapsed >= OCCLUDED_FRAME_DONE_INTERVAL_MS;
+	bool sent_occluded = false, occluded_pending = false;
+
+	int width, height;
+	wlr_output_effective_resolution(output->wlr_output, &width, &height);
+
+	pixman_region32_t opaque;
+	pixman_region32_init(&opaque);
+
+	// Walk from top to bottom, accumulating the opaque region covering the
+	// surfaces below
+	struct frame_done_entry *entries = data.entries.data;
+	size_t len = data.entries.size / sizeof(struct frame_done_entry);
+	for (size_t i = len; i-- > 0;) {
+		struct frame_done_entry *entry = &entries[i];
+		struct wlr_surface *surface = entry->surface;
+		struct wlr_box *box = &entry->box;
+
+		bool is_visible = false;
+		if (!entry->hidden) {
+			pixman_region32_t visible;
+			pixman_region32_init_rect(&visible,
+				box->x, box->y, box->width, box->height);
+			pixman_region32_intersect_rect(&visible, &visible,
+				0, 0, width, height);
+			pixman_region32_subtract(&visible, &visible, &opaque);
+			is_visible = pixman_region32_not_empty(&visible);
+			pixman_region32_fini(&visible);
+		}
+
+		if (is_visible) {
+			wlr_surface_send_frame_done(surface, when);
+		} else if (!wl_list_empty(&surface->current.frame_callback_list)) {
+			if (send_occluded) {
+				wlr_surface_send_frame_done(surface, when);
+				sent_occluded = true;
+			} else {
+				occluded_pending = true;
+			}
+		}
+
+		if (entry->opaque) {
+			pixman_region32_t surface_opaque;
+			pixman_region32_init(&surface_opaque);
+			pixman_region32_copy(&surface_opaque, &surface->opaque_region);
+			pixman_region32_translate(&surface_opaque, box->x, box->y);
+			pixman_region32_union(&opaque, &opaque, &surface_opaque);
+			pixman_region32_fini(&surface_opaque);
+		}
+	}
+
+	pixman_region32_fini(&opaque);
+	wl_array_release(&data.entries);
+
+	if (sent_occluded) {
+		output->last_occluded_frame_done = *when;
+	} else if (occluded_pending) {
+		// Nothing may be rendered in the meantime, wake up when the
+		// throttled surfaces are due
+		int64_t delay = OCCLUDED_FRAME_DONE_INTERVAL_MS - elapsed;
+		wl_event_source_timer_update(output->frame_done_timer,
+			delay > 0 ? delay : 1);
+	}
 }
 
 void output_render(struct roots_output *output) {
@@ -417,6 +603,5 @@ buffer_damage_finish:
 	pixman_region32_fini(&buffer_damage);
 
 send_frame_done:
-	// Send frame done events to all surfaces
-	output_for_each_surface(output, surface_send_frame_done_iterator, &now);
+	send_frame_done(output, &now);
 }
@@ -389,7 +389,7 @@ void view_child_destroy(struct roots_view_child *child) {
 static void view_child_handle_commit(struct wl_listener *listener,
 		void *data) {
 	struct roots_view_child *child = wl_container_of(listener, child, commit);
-	view_apply_damage(child->view);
+	view_apply_damage(child->view, child->wlr_surface);
 }
 
 static void view_child_handle_new_subsurface(struct wl_listener *listener,
@@ -550,10 +550,35 @@ void view_setup(struct roots_view *view) {
 	view_update_output(view, NULL);
 }
 
-void view_apply_damage(struct roots_view *view) {
+struct find_surface_data {
+	struct wlr_surface *surface;
+	int sx, sy;
+	bool found;
+};
+
+static void find_surface_iterator(struct wlr_surface *surface,
+		int sx, int sy, void *_data) {
+	struct find_surface_data *data = _data;
+	if (!data->found && surface == data->surface) {
+		data->sx = sx;
+		data->sy = sy;
+		data->found = true;
+	}
+}
+
+void view_apply_damage(struct roots_view *view, struct wlr_surface *surface) {
+	// Locate the committed surface once, then only damage its tree on each
+	// output instead of walking the whole view for every output
+	struct find_surface_data data = { .surface = surface };
+	view_for_each_surface(view, find_surface_iterator, &data);
+	if (!data.found) {
+		return;
+	}
+
 	struct roots_output *output;
 	wl_list_for_each(output, &view->desktop->outputs, link) {
-		output_damage_from_view(output, view);
+		output_damage_from_view_surface(output, view, surface,
+			data.sx, data.sy);
 	}
 }
 
@@ -374,7 +374,7 @@ static void handle_surface_commit(struct wl_listener *listener, void *data) {
 		return;
 	}
 
-	view_apply_damage(view);
+	view_apply_damage(view, view->wlr_surface);
 
 	struct wlr_box size;
 	get_size(view, &size);
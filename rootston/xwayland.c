@@ -236,7 +236,7 @@ static void handle_surface_commit(struct wl_listener *listener, void *data) {
 	struct roots_view *view = &roots_surface->view;
 	struct wlr_surface *wlr_surface = view->wlr_surface;
 
-	view_apply_damage(view);
+	view_apply_damage(view, wlr_surface);
 
 	int width = wlr_surface->current.width;
 	int height = wlr_surface->current.height;
@@ -56,6 +56,13 @@ static void seat_handle_get_touch(struct wl_client *client,
 	seat_client_create_touch(seat_client, version, id);
 }
 
+void seat_client_count_event(struct wlr_seat_client *seat_client,
+		size_t n_args) {
+	// The wire format has an 8-byte header per message
+	seat_client->stats.events++;
+	seat_client->stats.bytes += 8 + 4 * n_args;
+}
+
 static void seat_client_handle_resource_destroy(
 		struct wl_resource *seat_resource) {
 	struct wlr_seat_client *client =
@@ -85,6 +92,7 @@ static void seat_client_handle_resource_destroy(
 	wl_resource_for_each_safe(resource, tmp, &client->touches) {
 		wl_resource_destroy(resource);
 	}
+	seat_client_cancel_touch_frame(client);
 	wl_resource_for_each_safe(resource, tmp, &client->data_devices) {
 		// Make the data device inert
 		wl_resource_set_user_data(resource, NULL);
@@ -14,6 +14,7 @@
 #include "types/wlr_seat.h"
 #include "util/shm.h"
 #include "util/signal.h"
+#include "util/trace.h"
 
 static void default_keyboard_enter(struct wlr_seat_keyboard_grab *grab,
 		struct wlr_surface *surface, uint32_t keycodes[], size_t num_keycodes,
@@ -80,6 +81,7 @@ void wlr_seat_keyboard_send_key(struct wlr_seat *wlr_seat, uint32_t time,
 		}
 
 		wl_keyboard_send_key(resource, serial, time, key, state);
+		seat_client_count_event(client, 4);
 	}
 }
 
@@ -215,6 +217,7 @@ void wlr_seat_keyboard_send_modifiers(struct wlr_seat *seat,
 				modifiers->depressed, modifiers->latched,
 				modifiers->locked, modifiers->group);
 		}
+		seat_client_count_event(client, 5);
 	}
 }
 
@@ -331,6 +334,9 @@ void wlr_seat_keyboard_notify_key(struct wlr_seat *seat, uint32_t time,
 	clock_gettime(CLOCK_MONOTONIC, &seat->last_event);
 	struct wlr_seat_keyboard_grab *grab = seat->keyboard_state.grab;
 	grab->interface->key(grab, time, key, state);
+
+	struct wlr_seat_client *client = seat->keyboard_state.focused_client;
+	trace_seat_notify(client != NULL ? client->client : NULL);
 }
 
 
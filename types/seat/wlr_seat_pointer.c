@@ -9,6 +9,7 @@
 #include "types/wlr_seat.h"
 #include "util/signal.h"
 #include "util/array.h"
+#include "util/trace.h"
 
 static void default_pointer_enter(struct wlr_seat_pointer_grab *grab,
 		struct wlr_surface *surface, double sx, double sy) {
@@ -229,6 +230,7 @@ void wlr_seat_pointer_send_motion(struct wlr_seat *wlr_seat, uint32_t time,
 
 		wl_pointer_send_motion(resource, time, wl_fixed_from_double(sx),
 			wl_fixed_from_double(sy));
+		seat_client_count_event(client, 3);
 	}
 
 	wlr_seat->pointer_state.sx = sx;
@@ -250,6 +252,7 @@ uint32_t wlr_seat_pointer_send_button(struct wlr_seat *wlr_seat, uint32_t time,
 		}
 
 		wl_pointer_send_button(resource, serial, time, button, state);
+		seat_client_count_event(client, 4);
 	}
 	return serial;
 }
@@ -272,18 +275,22 @@ void wlr_seat_pointer_send_axis(struct wlr_seat *wlr_seat, uint32_t time,
 
 		if (version >= WL_POINTER_AXIS_SOURCE_SINCE_VERSION) {
 			wl_pointer_send_axis_source(resource, source);
+			seat_client_count_event(client, 1);
 		}
 		if (value) {
 			if (value_discrete &&
 					version >= WL_POINTER_AXIS_DISCRETE_SINCE_VERSION) {
 				wl_pointer_send_axis_discrete(resource, orientation,
 					value_discrete);
+				seat_client_count_event(client, 2);
 			}
 
 			wl_pointer_send_axis(resource, time, orientation,
 				wl_fixed_from_double(value));
+			seat_client_count_event(client, 3);
 		} else if (version >= WL_POINTER_AXIS_STOP_SINCE_VERSION) {
 			wl_pointer_send_axis_stop(resource, time, orientation);
+			seat_client_count_event(client, 2);
 		}
 	}
 }
@@ -300,7 +307,11 @@ void wlr_seat_pointer_send_frame(struct wlr_seat *wlr_seat) {
 			continue;
 		}
 
-		pointer_send_frame(resource);
+		if (wl_resource_get_version(resource) >=
+				WL_POINTER_FRAME_SINCE_VERSION) {
+			wl_pointer_send_frame(resource);
+			seat_client_count_event(client, 0);
+		}
 	}
 }
 
@@ -330,11 +341,17 @@ void wlr_seat_pointer_notify_enter(struct wlr_seat *wlr_seat,
 	grab->interface->enter(grab, surface, sx, sy);
 }
 
+static struct wl_client *pointer_focused_wl_client(struct wlr_seat *wlr_seat) {
+	struct wlr_seat_client *client = wlr_seat->pointer_state.focused_client;
+	return client != NULL ? client->client : NULL;
+}
+
 void wlr_seat_pointer_notify_motion(struct wlr_seat *wlr_seat, uint32_t time,
 		double sx, double sy) {
 	clock_gettime(CLOCK_MONOTONIC, &wlr_seat->last_event);
 	struct wlr_seat_pointer_grab *grab = wlr_seat->pointer_state.grab;
 	grab->interface->motion(grab, time, sx, sy);
+	trace_seat_notify(pointer_focused_wl_client(wlr_seat));
 }
 
 uint32_t wlr_seat_pointer_notify_button(struct wlr_seat *wlr_seat,
@@ -358,6 +375,7 @@ uint32_t wlr_seat_pointer_notify_button(struct wlr_seat *wlr_seat,
 
 	struct wlr_seat_pointer_grab *grab = pointer_state->grab;
 	uint32_t serial = grab->interface->button(grab, time, button, state);
+	trace_seat_notify(pointer_focused_wl_client(wlr_seat));
 
 	wlr_log(WLR_DEBUG, "button_count=%zu grab_serial=%"PRIu32" serial=%"PRIu32"",
 		pointer_state->button_count,
@@ -378,6 +396,7 @@ void wlr_seat_pointer_notify_axis(struct wlr_seat *wlr_seat, uint32_t time,
 	struct wlr_seat_pointer_grab *grab = wlr_seat->pointer_state.grab;
 	grab->interface->axis(grab, time, orientation, value, value_discrete,
 		source);
+	trace_seat_notify(pointer_focused_wl_client(wlr_seat));
 }
 
 void wlr_seat_pointer_notify_frame(struct wlr_seat *wlr_seat) {
@@ -8,6 +8,7 @@
 #include <wlr/util/log.h>
 #include "types/wlr_seat.h"
 #include "util/signal.h"
+#include "util/trace.h"
 
 static uint32_t default_touch_down(struct wlr_seat_touch_grab *grab,
 		uint32_t time, struct wlr_touch_point *point) {
@@ -174,6 +175,7 @@ uint32_t wlr_seat_touch_notify_down(struct wlr_seat *seat,
 	}
 
 	uint32_t serial = grab->interface->down(grab, time, point);
+	trace_seat_notify(point->client != NULL ? point->client->client : NULL);
 
 	if (serial && wlr_seat_touch_num_points(seat) == 1) {
 		seat->touch_state.grab_serial = serial;
@@ -193,6 +195,7 @@ void wlr_seat_touch_notify_up(struct wlr_seat *seat, uint32_t time,
 	}
 
 	grab->interface->up(grab, time, point);
+	trace_seat_notify(point->client != NULL ? point->client->client : NULL);
 
 	touch_point_destroy(point);
 }
@@ -210,6 +213,7 @@ void wlr_seat_touch_notify_motion(struct wlr_seat *seat, uint32_t time,
 	point->sy = sy;
 
 	grab->interface->motion(grab, time, point);
+	trace_seat_notify(point->client != NULL ? point->client->client : NULL);
 }
 
 static void handle_point_focus_destroy(struct wl_listener *listener,
@@ -272,6 +276,40 @@ void wlr_seat_touch_point_clear_focus(struct wlr_seat *seat, uint32_t time,
 	touch_point_clear_focus(point);
 }
 
+void seat_client_cancel_touch_frame(struct wlr_seat_client *seat_client) {
+	if (seat_client->touch_frame_idle != NULL) {
+		wl_event_source_remove(seat_client->touch_frame_idle);
+		seat_client->touch_frame_idle = NULL;
+	}
+}
+
+static void seat_client_send_touch_frame(struct wlr_seat_client *seat_client) {
+	seat_client_cancel_touch_frame(seat_client);
+
+	struct wl_resource *resource;
+	wl_resource_for_each(resource, &seat_client->touches) {
+		if (seat_client_from_touch_resource(resource) == NULL) {
+			continue;
+		}
+		wl_touch_send_frame(resource);
+		seat_client_count_event(seat_client, 0);
+	}
+
+	struct wlr_touch_point *point;
+	wl_list_for_each(point, &seat_client->seat->touch_state.touch_points,
+			link) {
+		if (point->client == seat_client) {
+			point->frame_pending = false;
+		}
+	}
+}
+
+static void handle_touch_frame_idle(void *data) {
+	struct wlr_seat_client *seat_client = data;
+	seat_client->touch_frame_idle = NULL;
+	seat_client_send_touch_frame(seat_client);
+}
+
 uint32_t wlr_seat_touch_send_down(struct wlr_seat *seat,
 		struct wlr_surface *surface, uint32_t time, int32_t touch_id, double sx,
 		double sy) {
@@ -289,8 +327,11 @@ uint32_t wlr_seat_touch_send_down(struct wlr_seat *seat,
 		}
 		wl_touch_send_down(resource, serial, time, surface->resource,
 			touch_id, wl_fixed_from_double(sx), wl_fixed_from_double(sy));
-		wl_touch_send_frame(resource);
+		seat_client_count_event(point->client, 6);
 	}
+	// Down and up events end the current frame, so that they're never grouped
+	// with other events for the same touch point
+	seat_client_send_touch_frame(point->client);
 
 	return serial;
 }
@@ -309,8 +350,9 @@ void wlr_seat_touch_send_up(struct wlr_seat *seat, uint32_t time, int32_t touch_
 			continue;
 		}
 		wl_touch_send_up(resource, serial, time, touch_id);
-		wl_touch_send_frame(resource);
+		seat_client_count_event(point->client, 4);
 	}
+	seat_client_send_touch_frame(point->client);
 }
 
 void wlr_seat_touch_send_motion(struct wlr_seat *seat, uint32_t time, int32_t touch_id,
@@ -321,14 +363,28 @@ void wlr_seat_touch_send_motion(struct wlr_seat *seat, uint32_t time, int32_t to
 		return;
 	}
 
+	struct wlr_seat_client *client = point->client;
+	if (point->frame_pending) {
+		// This touch point already moved in the current frame
+		seat_client_send_touch_frame(client);
+	}
+
 	struct wl_resource *resource;
-	wl_resource_for_each(resource, &point->client->touches) {
+	wl_resource_for_each(resource, &client->touches) {
 		if (seat_client_from_touch_resource(resource) == NULL) {
 			continue;
 		}
 		wl_touch_send_motion(resource, time, touch_id, wl_fixed_from_double(sx),
 			wl_fixed_from_double(sy));
-		wl_touch_send_frame(resource);
+		seat_client_count_event(client, 4);
+	}
+
+	point->frame_pending = true;
+	if (client->touch_frame_idle == NULL) {
+		struct wl_event_loop *loop =
+			wl_display_get_event_loop(seat->display);
+		client->touch_frame_idle =
+			wl_event_loop_add_idle(loop, handle_touch_frame_idle, client);
 	}
 }
 
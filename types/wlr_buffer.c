@@ -4,6 +4,8 @@
 #include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_linux_dmabuf_v1.h>
 #include <wlr/util/log.h>
+#include "util/signal.h"
+#include "util/trace.h"
 
 bool wlr_resource_is_buffer(struct wl_resource *resource) {
 	return strcmp(wl_resource_get_class(resource), wl_buffer_interface.name) == 0;
@@ -59,17 +61,25 @@ struct wlr_buffer *wlr_buffer_create(struct wlr_renderer *renderer,
 	bool released = false;
 
 	struct wl_shm_buffer *shm_buf = wl_shm_buffer_get(resource);
-	if (shm_buf != NULL) {
+	if (shm_buf != NULL &&
+			(texture = wlr_texture_from_wl_shm(renderer, resource)) != NULL) {
+		// The texture reads the client's memory, the buffer will be released
+		// once we're done with it
+	} else if (shm_buf != NULL) {
 		enum wl_shm_format fmt = wl_shm_buffer_get_format(shm_buf);
 		int32_t stride = wl_shm_buffer_get_stride(shm_buf);
 		int32_t width = wl_shm_buffer_get_width(shm_buf);
 		int32_t height = wl_shm_buffer_get_height(shm_buf);
 
+		trace_begin("wlr_buffer_upload");
 		wl_shm_buffer_begin_access(shm_buf);
 		void *data = wl_shm_buffer_get_data(shm_buf);
 		texture = wlr_texture_from_pixels(renderer, fmt, stride,
 			width, height, data);
 		wl_shm_buffer_end_access(shm_buf);
+		trace_counter("wlr_buffer_upload_bytes", NULL,
+			(int64_t)stride * height);
+		trace_end();
 
 		// We have uploaded the data, we don't need to access the wl_buffer
 		// anymore
@@ -80,7 +90,13 @@ struct wlr_buffer *wlr_buffer_create(struct wlr_renderer *renderer,
 	} else if (wlr_dmabuf_v1_resource_is_buffer(resource)) {
 		struct wlr_dmabuf_v1_buffer *dmabuf =
 			wlr_dmabuf_v1_buffer_from_buffer_resource(resource);
-		texture = wlr_texture_from_dmabuf(renderer, &dmabuf->attributes);
+		if (dmabuf->texture != NULL && dmabuf->renderer == renderer) {
+			// Re-use the texture imported when the buffer was created
+			texture = dmabuf->texture;
+			dmabuf->texture = NULL;
+		} else {
+			texture = wlr_texture_from_dmabuf(renderer, &dmabuf->attributes);
+		}
 
 		// We have imported the DMA-BUF, but we need to prevent the client from
 		// re-using the same DMA-BUF for the next frames, so we don't release
@@ -108,6 +124,7 @@ struct wlr_buffer *wlr_buffer_create(struct wlr_renderer *renderer,
 	buffer->texture = texture;
 	buffer->released = released;
 	buffer->n_refs = 1;
+	wl_signal_init(&buffer->events.destroy);
 
 	wl_resource_add_destroy_listener(resource, &buffer->resource_destroy);
 	buffer->resource_destroy.notify = buffer_resource_handle_destroy;
@@ -131,6 +148,8 @@ void wlr_buffer_unref(struct wlr_buffer *buffer) {
 		return;
 	}
 
+	wlr_signal_emit_safe(&buffer->events.destroy, buffer);
+
 	if (!buffer->released && buffer->resource != NULL) {
 		wl_buffer_send_release(buffer->resource);
 	}
@@ -148,6 +167,10 @@ struct wlr_buffer *wlr_buffer_apply_damage(struct wlr_buffer *buffer,
 		// Someone else still has a reference to the buffer
 		return NULL;
 	}
+	if (!buffer->released) {
+		// The texture still references the previous buffer's memory
+		return NULL;
+	}
 
 	struct wl_shm_buffer *shm_buf = wl_shm_buffer_get(resource);
 	struct wl_shm_buffer *old_shm_buf = wl_shm_buffer_get(buffer->resource);
@@ -174,9 +197,11 @@ struct wlr_buffer *wlr_buffer_apply_damage(struct wlr_buffer *buffer,
 		return NULL;
 	}
 
+	trace_begin("wlr_buffer_upload");
 	wl_shm_buffer_begin_access(shm_buf);
 	void *data = wl_shm_buffer_get_data(shm_buf);
 
+	int64_t bytes = 0;
 	int n;
 	pixman_box32_t *rects = pixman_region32_rectangles(damage, &n);
 	for (int i = 0; i < n; ++i) {
@@ -185,11 +210,16 @@ struct wlr_buffer *wlr_buffer_apply_damage(struct wlr_buffer *buffer,
 				r->x2 - r->x1, r->y2 - r->y1, r->x1, r->y1,
 				r->x1, r->y1, data)) {
 			wl_shm_buffer_end_access(shm_buf);
+			trace_end();
 			return NULL;
 		}
+		bytes += (int64_t)(r->x2 - r->x1) * (stride / width) *
+			(r->y2 - r->y1);
 	}
 
 	wl_shm_buffer_end_access(shm_buf);
+	trace_counter("wlr_buffer_upload_bytes", NULL, bytes);
+	trace_end();
 
 	// We have uploaded the data, we don't need to access the wl_buffer
 	// anymore
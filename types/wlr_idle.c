@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <wayland-server.h>
 #include <wlr/types/wlr_idle.h>
 #include <wlr/util/log.h>
@@ -16,10 +17,19 @@ static struct wlr_idle_timeout *idle_timeout_from_resource(
 	return wl_resource_get_user_data(resource);
 }
 
-static int idle_notify(void *data) {
-	struct wlr_idle_timeout *timer = data;
+static inline int64_t timespec_to_msec(const struct timespec *a) {
+	return (int64_t)a->tv_sec * 1000 + a->tv_nsec / 1000000;
+}
+
+static int64_t get_current_time_msec(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return timespec_to_msec(&now);
+}
+
+static void idle_notify(struct wlr_idle_timeout *timer) {
 	if (timer->idle_state) {
-		return 0;
+		return;
 	}
 	timer->idle_state = true;
 	wlr_signal_emit_safe(&timer->events.idle, timer);
@@ -27,7 +37,58 @@ static int idle_notify(void *data) {
 	if (timer->resource) {
 		org_kde_kwin_idle_timeout_send_idle(timer->resource);
 	}
-	return 1;
+}
+
+/**
+ * Make sure the idle timer fires at or before the deadline. Input events only
+ * ever push deadlines back, so the timer is left alone for them and re-armed
+ * lazily when it fires.
+ */
+static void idle_schedule(struct wlr_idle *idle, int64_t deadline,
+		int64_t now) {
+	if (idle->next_deadline != 0 && idle->next_deadline <= deadline) {
+		return;
+	}
+	idle->next_deadline = deadline;
+
+	// A zero delay would disarm the timer
+	int64_t delay = deadline - now;
+	wl_event_source_timer_update(idle->idle_source, delay > 0 ? delay : 1);
+}
+
+static void timeout_start(struct wlr_idle_timeout *timer, int64_t now) {
+	timer->last_activity = now;
+	if (timer->timeout == 0) {
+		idle_notify(timer);
+	} else {
+		idle_schedule(timer->idle, now + timer->timeout, now);
+	}
+}
+
+static int handle_idle_timer(void *data) {
+	struct wlr_idle *idle = data;
+	idle->next_deadline = 0;
+
+	int64_t now = get_current_time_msec();
+	int64_t next_deadline = 0;
+	struct wlr_idle_timeout *timer, *tmp;
+	wl_list_for_each_safe(timer, tmp, &idle->idle_timers, link) {
+		if (!timer->enabled || timer->idle_state) {
+			continue;
+		}
+
+		int64_t deadline = timer->last_activity + timer->timeout;
+		if (deadline <= now) {
+			idle_notify(timer);
+		} else if (next_deadline == 0 || deadline < next_deadline) {
+			next_deadline = deadline;
+		}
+	}
+
+	if (next_deadline != 0) {
+		idle_schedule(idle, next_deadline, now);
+	}
+	return 0;
 }
 
 static void handle_activity(struct wlr_idle_timeout *timer) {
@@ -35,6 +96,8 @@ static void handle_activity(struct wlr_idle_timeout *timer) {
 		return;
 	}
 
+	int64_t now = get_current_time_msec();
+
 	// in case the previous state was sleeping send a resume event and switch state
 	if (timer->idle_state) {
 		timer->idle_state = false;
@@ -43,10 +106,13 @@ static void handle_activity(struct wlr_idle_timeout *timer) {
 		if (timer->resource) {
 			org_kde_kwin_idle_timeout_send_resumed(timer->resource);
 		}
+
+		timeout_start(timer, now);
+		return;
 	}
 
-	// rearm the timer
-	wl_event_source_timer_update(timer->idle_source, timer->timeout);
+	// The deadline only moves back, the idle timer will pick it up
+	timer->last_activity = now;
 	if (timer->timeout == 0) {
 		idle_notify(timer);
 	}
@@ -108,6 +174,7 @@ static struct wlr_idle_timeout *create_timer(struct wlr_idle *idle,
 		return NULL;
 	}
 
+	timer->idle = idle;
 	timer->seat = seat;
 	timer->timeout = timeout;
 	timer->idle_state = false;
@@ -123,16 +190,6 @@ static struct wlr_idle_timeout *create_timer(struct wlr_idle *idle,
 
 	timer->input_listener.notify = handle_input_notification;
 	wl_signal_add(&idle->events.activity_notify, &timer->input_listener);
-	// create the timer
-	timer->idle_source =
-		wl_event_loop_add_timer(idle->event_loop, idle_notify, timer);
-	if (timer->idle_source == NULL) {
-		wl_list_remove(&timer->link);
-		wl_list_remove(&timer->input_listener.link);
-		wl_list_remove(&timer->seat_destroy.link);
-		free(timer);
-		return NULL;
-	}
 
 	if (resource) {
 		timer->resource = resource;
@@ -140,11 +197,7 @@ static struct wlr_idle_timeout *create_timer(struct wlr_idle *idle,
 	}
 
 	if (timer->enabled) {
-		// arm the timer
-		wl_event_source_timer_update(timer->idle_source, timer->timeout);
-		if (timer->timeout == 0) {
-			idle_notify(timer);
-		}
+		timeout_start(timer, get_current_time_msec());
 	}
 
 	return timer;
@@ -185,14 +238,17 @@ void wlr_idle_set_enabled(struct wlr_idle *idle, struct wlr_seat *seat,
 		enabled ? "Enabling" : "Disabling",
 		seat ? seat->name : "all seats");
 	idle->enabled = enabled;
+	int64_t now = get_current_time_msec();
 	struct wlr_idle_timeout *timer;
 	wl_list_for_each(timer, &idle->idle_timers, link) {
 		if (seat != NULL && timer->seat != seat) {
 			continue;
 		}
-		int timeout = enabled ? timer->timeout : 0;
-		wl_event_source_timer_update(timer->idle_source, timeout);
+		// Disabled timers are skipped when the idle timer fires
 		timer->enabled = enabled;
+		if (enabled && !timer->idle_state) {
+			timeout_start(timer, now);
+		}
 	}
 }
 
@@ -220,6 +276,7 @@ void wlr_idle_destroy(struct wlr_idle *idle) {
 	wl_list_for_each_safe(timer, tmp, &idle->idle_timers, link) {
 		wlr_idle_timeout_destroy(timer);
 	}
+	wl_event_source_remove(idle->idle_source);
 	wl_global_destroy(idle->global);
 	free(idle);
 }
@@ -245,6 +302,13 @@ struct wlr_idle *wlr_idle_create(struct wl_display *display) {
 		return NULL;
 	}
 
+	idle->idle_source =
+		wl_event_loop_add_timer(idle->event_loop, handle_idle_timer, idle);
+	if (idle->idle_source == NULL) {
+		free(idle);
+		return NULL;
+	}
+
 	idle->display_destroy.notify = handle_display_destroy;
 	wl_display_add_destroy_listener(display, &idle->display_destroy);
 
@@ -252,6 +316,7 @@ struct wlr_idle *wlr_idle_create(struct wl_display *display) {
 				1, idle, idle_bind);
 	if (idle->global == NULL) {
 		wl_list_remove(&idle->display_destroy.link);
+		wl_event_source_remove(idle->idle_source);
 		free(idle);
 		return NULL;
 	}
@@ -273,7 +338,6 @@ void wlr_idle_timeout_destroy(struct wlr_idle_timeout *timer) {
 
 	wl_list_remove(&timer->input_listener.link);
 	wl_list_remove(&timer->seat_destroy.link);
-	wl_event_source_remove(timer->idle_source);
 	wl_list_remove(&timer->link);
 
 	if (timer->resource) {
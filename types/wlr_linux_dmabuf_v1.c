@@ -54,6 +54,8 @@ struct wlr_dmabuf_v1_buffer *wlr_dmabuf_v1_buffer_from_buffer_resource(
 }
 
 static void linux_dmabuf_buffer_destroy(struct wlr_dmabuf_v1_buffer *buffer) {
+	wl_list_remove(&buffer->renderer_destroy.link);
+	wlr_texture_destroy(buffer->texture);
 	wlr_dmabuf_attributes_finish(&buffer->attributes);
 	free(buffer);
 }
@@ -122,15 +124,19 @@ static void buffer_handle_resource_destroy(struct wl_resource *buffer_resource)
 }
 
 static bool check_import_dmabuf(struct wlr_dmabuf_v1_buffer *buffer) {
+	if (buffer->renderer == NULL) {
+		return false;
+	}
+
 	struct wlr_texture *texture =
 		wlr_texture_from_dmabuf(buffer->renderer, &buffer->attributes);
 	if (texture == NULL) {
 		return false;
 	}
 
-	// We can import the image, good. No need to keep it since wlr_surface will
-	// import it again on commit.
-	wlr_texture_destroy(texture);
+	// We can import the image, good. Keep it so that wlr_surface doesn't need
+	// to import it again on commit.
+	buffer->texture = texture;
 	return true;
 }
 
@@ -332,6 +338,18 @@ static void handle_params_destroy(struct wl_resource *params_resource) {
 	linux_dmabuf_buffer_destroy(buffer);
 }
 
+static void buffer_handle_renderer_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_dmabuf_v1_buffer *buffer =
+		wl_container_of(listener, buffer, renderer_destroy);
+	// The cached texture belongs to the renderer being destroyed
+	wlr_texture_destroy(buffer->texture);
+	buffer->texture = NULL;
+	buffer->renderer = NULL;
+	wl_list_remove(&buffer->renderer_destroy.link);
+	wl_list_init(&buffer->renderer_destroy.link);
+}
+
 static void linux_dmabuf_create_params(struct wl_client *client,
 		struct wl_resource *linux_dmabuf_resource,
 		uint32_t params_id) {
@@ -349,6 +367,9 @@ static void linux_dmabuf_create_params(struct wl_client *client,
 	}
 
 	buffer->renderer = linux_dmabuf->renderer;
+	buffer->renderer_destroy.notify = buffer_handle_renderer_destroy;
+	wl_signal_add(&buffer->renderer->events.destroy, &buffer->renderer_destroy);
+
 	buffer->params_resource = wl_resource_create(client,
 		&zwp_linux_buffer_params_v1_interface, version, params_id);
 	if (!buffer->params_resource) {
@@ -360,6 +381,7 @@ static void linux_dmabuf_create_params(struct wl_client *client,
 	return;
 
 err_free:
+	wl_list_remove(&buffer->renderer_destroy.link);
 	free(buffer);
 err:
 	wl_resource_post_no_memory(linux_dmabuf_resource);
@@ -0,0 +1,492 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/types/wlr_buffer.h>
+#include <wlr/types/wlr_linux_dmabuf_v1.h>
+#include <wlr/types/wlr_linux_explicit_synchronization_v1.h>
+#include <wlr/types/wlr_surface.h>
+#include <wlr/util/log.h>
+#include "linux-explicit-synchronization-unstable-v1-protocol.h"
+#include "util/signal.h"
+
+#if defined(__linux__)
+#include <linux/sync_file.h>
+#endif
+
+#define LINUX_EXPLICIT_SYNCHRONIZATION_VERSION 1
+
+static const struct zwp_linux_explicit_synchronization_v1_interface
+	explicit_sync_impl;
+
+static struct wlr_linux_explicit_synchronization_v1 *
+explicit_sync_from_resource(struct wl_resource *resource) {
+	assert(wl_resource_instance_of(resource,
+		&zwp_linux_explicit_synchronization_v1_interface,
+		&explicit_sync_impl));
+	return wl_resource_get_user_data(resource);
+}
+
+static const struct zwp_linux_surface_synchronization_v1_interface
+	surface_sync_impl;
+
+// Returns NULL if the surface has been destroyed
+static struct wlr_linux_surface_synchronization_v1 *
+surface_sync_from_resource(struct wl_resource *resource) {
+	assert(wl_resource_instance_of(resource,
+		&zwp_linux_surface_synchronization_v1_interface,
+		&surface_sync_impl));
+	return wl_resource_get_user_data(resource);
+}
+
+static struct wlr_linux_buffer_release_v1 *buffer_release_from_resource(
+		struct wl_resource *resource) {
+	assert(wl_resource_instance_of(resource,
+		&zwp_linux_buffer_release_v1_interface, NULL));
+	return wl_resource_get_user_data(resource);
+}
+
+static void buffer_release_handle_resource_destroy(
+		struct wl_resource *resource) {
+	struct wlr_linux_buffer_release_v1 *release =
+		buffer_release_from_resource(resource);
+	if (release->state != NULL) {
+		// The client is gone, there is no one to notify
+		release->state->buffer_release = NULL;
+	}
+	wl_list_remove(&release->buffer_destroy.link);
+	free(release);
+}
+
+// Destroys the buffer release
+static void buffer_release_send(struct wlr_linux_buffer_release_v1 *release) {
+	// The renderer may still have pending operations reading the buffer
+	int fence_fd = wlr_renderer_export_fence(release->renderer);
+	if (fence_fd >= 0) {
+		zwp_linux_buffer_release_v1_send_fenced_release(release->resource,
+			fence_fd);
+		close(fence_fd);
+	} else {
+		zwp_linux_buffer_release_v1_send_immediate_release(release->resource);
+	}
+	wl_resource_destroy(release->resource);
+}
+
+static void buffer_release_handle_buffer_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_linux_buffer_release_v1 *release =
+		wl_container_of(listener, release, buffer_destroy);
+	buffer_release_send(release);
+}
+
+static bool is_sync_file(int fd) {
+#if defined(__linux__)
+	// With num_fences set to zero, only the file info is filled
+	struct sync_file_info info = {0};
+	return ioctl(fd, SYNC_IOC_FILE_INFO, &info) == 0;
+#else
+	return true;
+#endif
+}
+
+static void surface_sync_state_finish(
+		struct wlr_linux_surface_synchronization_v1_state *state) {
+	if (state->acquire_fence_fd >= 0) {
+		close(state->acquire_fence_fd);
+	}
+	state->acquire_fence_fd = -1;
+	if (state->buffer_release != NULL) {
+		state->buffer_release->state = NULL;
+	}
+	state->buffer_release = NULL;
+}
+
+static void surface_sync_state_move(
+		struct wlr_linux_surface_synchronization_v1_state *dst,
+		struct wlr_linux_surface_synchronization_v1_state *src) {
+	*dst = *src;
+	if (dst->buffer_release != NULL) {
+		dst->buffer_release->state = dst;
+	}
+	src->acquire_fence_fd = -1;
+	src->buffer_release = NULL;
+}
+
+// The buffer associated with the state will never be read
+static void surface_sync_state_discard(
+		struct wlr_linux_surface_synchronization_v1_state *state) {
+	struct wlr_linux_buffer_release_v1 *release = state->buffer_release;
+	surface_sync_state_finish(state);
+	if (release != NULL) {
+		buffer_release_send(release);
+	}
+}
+
+static void surface_sync_destroy(
+		struct wlr_linux_surface_synchronization_v1 *surface_sync) {
+	if (surface_sync == NULL) {
+		return;
+	}
+
+	wl_list_remove(&surface_sync->surface_destroy.link);
+	wl_list_remove(&surface_sync->surface_client_commit.link);
+	wl_list_remove(&surface_sync->surface_precommit.link);
+	wl_list_remove(&surface_sync->surface_commit.link);
+	wl_list_remove(&surface_sync->link);
+	wl_resource_set_user_data(surface_sync->resource, NULL);
+
+	// The buffers may still be read, but the client can't be told when
+	surface_sync_state_discard(&surface_sync->pending);
+	surface_sync_state_discard(&surface_sync->cached);
+	surface_sync_state_discard(&surface_sync->current);
+	free(surface_sync);
+}
+
+static void surface_sync_handle_destroy(struct wl_client *client,
+		struct wl_resource *resource) {
+	wl_resource_destroy(resource);
+}
+
+static void surface_sync_handle_set_acquire_fence(struct wl_client *client,
+		struct wl_resource *resource, int fd) {
+	struct wlr_linux_surface_synchronization_v1 *surface_sync =
+		surface_sync_from_resource(resource);
+	if (surface_sync == NULL) {
+		close(fd);
+		wl_resource_post_error(resource,
+			ZWP_LINUX_SURFACE_SYNCHRONIZATION_V1_ERROR_NO_SURFACE,
+			"the surface has been destroyed");
+		return;
+	}
+
+	if (surface_sync->pending.acquire_fence_fd >= 0) {
+		close(fd);
+		wl_resource_post_error(resource,
+			ZWP_LINUX_SURFACE_SYNCHRONIZATION_V1_ERROR_DUPLICATE_FENCE,
+			"an acquire fence has already been set for this commit");
+		return;
+	}
+
+	surface_sync->pending.acquire_fence_fd = fd;
+}
+
+static void surface_sync_handle_get_release(struct wl_client *client,
+		struct wl_resource *resource, uint32_t id) {
+	struct wlr_linux_surface_synchronization_v1 *surface_sync =
+		surface_sync_from_resource(resource);
+	if (surface_sync == NULL) {
+		wl_resource_post_error(resource,
+			ZWP_LINUX_SURFACE_SYNCHRONIZATION_V1_ERROR_NO_SURFACE,
+			"the surface has been destroyed");
+		return;
+	}
+
+	if (surface_sync->pending.buffer_release != NULL) {
+		wl_resource_post_error(resource,
+			ZWP_LINUX_SURFACE_SYNCHRONIZATION_V1_ERROR_DUPLICATE_RELEASE,
+			"a buffer release has already been requested for this commit");
+		return;
+	}
+
+	struct wlr_linux_buffer_release_v1 *release =
+		calloc(1, sizeof(struct wlr_linux_buffer_release_v1));
+	if (release == NULL) {
+		wl_client_post_no_memory(client);
+		return;
+	}
+
+	release->resource = wl_resource_create(client,
+		&zwp_linux_buffer_release_v1_interface,
+		wl_resource_get_version(resource), id);
+	if (release->resource == NULL) {
+		free(release);
+		wl_client_post_no_memory(client);
+		return;
+	}
+	wl_resource_set_implementation(release->resource, NULL, release,
+		buffer_release_handle_resource_destroy);
+
+	release->renderer = surface_sync->explicit_synchronization->renderer;
+	wl_list_init(&release->buffer_destroy.link);
+
+	surface_sync->pending.buffer_release = release;
+	release->state = &surface_sync->pending;
+}
+
+static const struct zwp_linux_surface_synchronization_v1_interface
+		surface_sync_impl = {
+	.destroy = surface_sync_handle_destroy,
+	.set_acquire_fence = surface_sync_handle_set_acquire_fence,
+	.get_release = surface_sync_handle_get_release,
+};
+
+static void surface_sync_handle_resource_destroy(struct wl_resource *resource) {
+	struct wlr_linux_surface_synchronization_v1 *surface_sync =
+		surface_sync_from_resource(resource);
+	surface_sync_destroy(surface_sync);
+}
+
+static void surface_sync_handle_surface_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_linux_surface_synchronization_v1 *surface_sync =
+		wl_container_of(listener, surface_sync, surface_destroy);
+	surface_sync_destroy(surface_sync);
+}
+
+static void surface_sync_handle_surface_client_commit(
+		struct wl_listener *listener, void *data) {
+	struct wlr_linux_surface_synchronization_v1 *surface_sync =
+		wl_container_of(listener, surface_sync, surface_client_commit);
+	struct wlr_surface *surface = surface_sync->surface;
+
+	if (surface->pending.committed & WLR_SURFACE_STATE_BUFFER) {
+		// A new buffer replaces the cached one, which won't be read
+		surface_sync_state_discard(&surface_sync->cached);
+	}
+
+	if (surface_sync->pending.acquire_fence_fd < 0 &&
+			surface_sync->pending.buffer_release == NULL) {
+		return;
+	}
+
+	struct wl_resource *buffer_resource = surface->pending.buffer_resource;
+	if (!(surface->pending.committed & WLR_SURFACE_STATE_BUFFER) ||
+			buffer_resource == NULL) {
+		wl_resource_post_error(surface_sync->resource,
+			ZWP_LINUX_SURFACE_SYNCHRONIZATION_V1_ERROR_NO_BUFFER,
+			"explicit synchronization requested without a buffer");
+		return;
+	}
+
+	// wl_shm buffers are copied on commit, only DMA-BUFs are read later on
+	if (!wlr_dmabuf_v1_resource_is_buffer(buffer_resource)) {
+		wl_resource_post_error(surface_sync->resource,
+			ZWP_LINUX_SURFACE_SYNCHRONIZATION_V1_ERROR_UNSUPPORTED_BUFFER,
+			"explicit synchronization is only supported for DMA-BUFs");
+		return;
+	}
+
+	surface_sync_state_move(&surface_sync->cached, &surface_sync->pending);
+}
+
+static void surface_sync_handle_surface_precommit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_linux_surface_synchronization_v1 *surface_sync =
+		wl_container_of(listener, surface_sync, surface_precommit);
+
+	// The state latched by the client commit is now being applied
+	surface_sync_state_finish(&surface_sync->current);
+	surface_sync_state_move(&surface_sync->current, &surface_sync->cached);
+}
+
+static void surface_sync_handle_surface_commit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_linux_surface_synchronization_v1 *surface_sync =
+		wl_container_of(listener, surface_sync, surface_commit);
+	struct wlr_surface *surface = surface_sync->surface;
+	struct wlr_renderer *renderer =
+		surface_sync->explicit_synchronization->renderer;
+
+	int fence_fd = surface_sync->current.acquire_fence_fd;
+	if (fence_fd >= 0) {
+		// Make the GPU wait for the client before sampling the buffer. Never
+		// wait on the CPU: a fence which doesn't signal would hang the
+		// compositor.
+		if (!is_sync_file(fence_fd)) {
+			wl_resource_post_error(surface_sync->resource,
+				ZWP_LINUX_SURFACE_SYNCHRONIZATION_V1_ERROR_INVALID_FENCE,
+				"the acquire fence isn't a valid sync_file");
+		} else if (!wlr_renderer_wait_fence(renderer, fence_fd)) {
+			wlr_log(WLR_ERROR, "Failed to wait for acquire fence");
+		}
+		close(fence_fd);
+		surface_sync->current.acquire_fence_fd = -1;
+	}
+
+	struct wlr_linux_buffer_release_v1 *release =
+		surface_sync->current.buffer_release;
+	if (release != NULL) {
+		surface_sync->current.buffer_release = NULL;
+		release->state = NULL;
+		if (surface->buffer == NULL) {
+			// The buffer failed to be imported, we won't ever read it
+			buffer_release_send(release);
+		} else {
+			release->buffer = surface->buffer;
+			release->buffer_destroy.notify =
+				buffer_release_handle_buffer_destroy;
+			wl_signal_add(&surface->buffer->events.destroy,
+				&release->buffer_destroy);
+		}
+	}
+}
+
+static void explicit_sync_handle_destroy(struct wl_client *client,
+		struct wl_resource *resource) {
+	wl_resource_destroy(resource);
+}
+
+static void explicit_sync_handle_get_synchronization(struct wl_client *client,
+		struct wl_resource *resource, uint32_t id,
+		struct wl_resource *surface_resource) {
+	struct wlr_linux_explicit_synchronization_v1 *explicit_sync =
+		explicit_sync_from_resource(resource);
+	struct wlr_surface *surface = wlr_surface_from_resource(surface_resource);
+
+	struct wlr_linux_surface_synchronization_v1 *surface_sync;
+	wl_list_for_each(surface_sync, &explicit_sync->surfaces, link) {
+		if (surface_sync->surface == surface) {
+			wl_resource_post_error(resource,
+				ZWP_LINUX_EXPLICIT_SYNCHRONIZATION_V1_ERROR_SYNCHRONIZATION_EXISTS,
+				"zwp_linux_surface_synchronization_v1 already created for "
+				"this surface");
+			return;
+		}
+	}
+
+	surface_sync =
+		calloc(1, sizeof(struct wlr_linux_surface_synchronization_v1));
+	if (surface_sync == NULL) {
+		wl_client_post_no_memory(client);
+		return;
+	}
+
+	surface_sync->resource = wl_resource_create(client,
+		&zwp_linux_surface_synchronization_v1_interface,
+		wl_resource_get_version(resource), id);
+	if (surface_sync->resource == NULL) {
+		free(surface_sync);
+		wl_client_post_no_memory(client);
+		return;
+	}
+	wl_resource_set_implementation(surface_sync->resource, &surface_sync_impl,
+		surface_sync, surface_sync_handle_resource_destroy);
+
+	surface_sync->surface = surface;
+	surface_sync->explicit_synchronization = explicit_sync;
+	surface_sync->pending.acquire_fence_fd = -1;
+	surface_sync->cached.acquire_fence_fd = -1;
+	surface_sync->current.acquire_fence_fd = -1;
+
+	surface_sync->surface_destroy.notify = surface_sync_handle_surface_destroy;
+	wl_signal_add(&surface->events.destroy, &surface_sync->surface_destroy);
+
+	surface_sync->surface_client_commit.notify =
+		surface_sync_handle_surface_client_commit;
+	wl_signal_add(&surface->events.client_commit,
+		&surface_sync->surface_client_commit);
+
+	surface_sync->surface_precommit.notify =
+		surface_sync_handle_surface_precommit;
+	wl_signal_add(&surface->events.precommit,
+		&surface_sync->surface_precommit);
+
+	surface_sync->surface_commit.notify = surface_sync_handle_surface_commit;
+	wl_signal_add(&surface->events.commit, &surface_sync->surface_commit);
+
+	wl_list_insert(&explicit_sync->surfaces, &surface_sync->link);
+}
+
+static const struct zwp_linux_explicit_synchronization_v1_interface
+		explicit_sync_impl = {
+	.destroy = explicit_sync_handle_destroy,
+	.get_synchronization = explicit_sync_handle_get_synchronization,
+};
+
+static void explicit_sync_handle_resource_destroy(
+		struct wl_resource *resource) {
+	wl_list_remove(wl_resource_get_link(resource));
+}
+
+static void explicit_sync_bind(struct wl_client *client, void *data,
+		uint32_t version, uint32_t id) {
+	struct wlr_linux_explicit_synchronization_v1 *explicit_sync = data;
+
+	struct wl_resource *resource = wl_resource_create(client,
+		&zwp_linux_explicit_synchronization_v1_interface, version, id);
+	if (resource == NULL) {
+		wl_client_post_no_memory(client);
+		return;
+	}
+	wl_resource_set_implementation(resource, &explicit_sync_impl,
+		explicit_sync, explicit_sync_handle_resource_destroy);
+	wl_list_insert(&explicit_sync->resources, wl_resource_get_link(resource));
+}
+
+static void handle_display_destroy(struct wl_listener *listener, void *data) {
+	struct wlr_linux_explicit_synchronization_v1 *explicit_sync =
+		wl_container_of(listener, explicit_sync, display_destroy);
+	wlr_linux_explicit_synchronization_v1_destroy(explicit_sync);
+}
+
+static void handle_renderer_destroy(struct wl_listener *listener, void *data) {
+	struct wlr_linux_explicit_synchronization_v1 *explicit_sync =
+		wl_container_of(listener, explicit_sync, renderer_destroy);
+	wlr_linux_explicit_synchronization_v1_destroy(explicit_sync);
+}
+
+struct wlr_linux_explicit_synchronization_v1 *
+		wlr_linux_explicit_synchronization_v1_create(struct wl_display *display,
+		struct wlr_renderer *renderer) {
+	if (!wlr_renderer_wait_fence_supported(renderer)) {
+		wlr_log(WLR_INFO, "Renderer doesn't support waiting for fences, "
+			"not advertising linux-explicit-synchronization");
+		return NULL;
+	}
+
+	struct wlr_linux_explicit_synchronization_v1 *explicit_sync =
+		calloc(1, sizeof(struct wlr_linux_explicit_synchronization_v1));
+	if (explicit_sync == NULL) {
+		return NULL;
+	}
+
+	explicit_sync->renderer = renderer;
+	wl_list_init(&explicit_sync->resources);
+	wl_list_init(&explicit_sync->surfaces);
+	wl_signal_init(&explicit_sync->events.destroy);
+
+	explicit_sync->global = wl_global_create(display,
+		&zwp_linux_explicit_synchronization_v1_interface,
+		LINUX_EXPLICIT_SYNCHRONIZATION_VERSION, explicit_sync,
+		explicit_sync_bind);
+	if (explicit_sync->global == NULL) {
+		free(explicit_sync);
+		return NULL;
+	}
+
+	explicit_sync->display_destroy.notify = handle_display_destroy;
+	wl_display_add_destroy_listener(display, &explicit_sync->display_destroy);
+
+	explicit_sync->renderer_destroy.notify = handle_renderer_destroy;
+	wl_signal_add(&renderer->events.destroy, &explicit_sync->renderer_destroy);
+
+	return explicit_sync;
+}
+
+void wlr_linux_explicit_synchronization_v1_destroy(
+		struct wlr_linux_explicit_synchronization_v1 *explicit_sync) {
+	if (explicit_sync == NULL) {
+		return;
+	}
+
+	wlr_signal_emit_safe(&explicit_sync->events.destroy, explicit_sync);
+
+	struct wlr_linux_surface_synchronization_v1 *surface_sync, *tmp_sync;
+	wl_list_for_each_safe(surface_sync, tmp_sync, &explicit_sync->surfaces,
+			link) {
+		surface_sync_destroy(surface_sync);
+	}
+
+	struct wl_resource *resource, *tmp_resource;
+	wl_resource_for_each_safe(resource, tmp_resource,
+			&explicit_sync->resources) {
+		wl_resource_destroy(resource);
+	}
+
+	wl_global_destroy(explicit_sync->global);
+	wl_list_remove(&explicit_sync->display_destroy.link);
+	wl_list_remove(&explicit_sync->renderer_destroy.link);
+	free(explicit_sync);
+}
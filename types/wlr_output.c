@@ -16,6 +16,7 @@
 #include <wlr/util/log.h>
 #include <wlr/util/region.h>
 #include "util/signal.h"
+#include "util/trace.h"
 
 #define OUTPUT_VERSION 3
 
@@ -451,12 +452,41 @@ void wlr_output_set_damage(struct wlr_output *output,
 	output->pending.committed |= WLR_OUTPUT_STATE_DAMAGE;
 }
 
+void wlr_output_enable_adaptive_sync(struct wlr_output *output, bool enabled) {
+	if (output->adaptive_sync_enabled == enabled) {
+		output->pending.committed &= ~WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED;
+		return;
+	}
+	output->pending.adaptive_sync_enabled = enabled;
+	output->pending.committed |= WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED;
+}
+
 static void output_state_clear(struct wlr_output_state *state) {
 	output_state_clear_buffer(state);
 	pixman_region32_clear(&state->damage);
 	state->committed = 0;
 }
 
+static void output_trace_damage(struct wlr_output *output) {
+	if (!trace_enabled()) {
+		return;
+	}
+
+	int64_t area = 0;
+	if (output->pending.committed & WLR_OUTPUT_STATE_DAMAGE) {
+		int n;
+		pixman_box32_t *rects =
+			pixman_region32_rectangles(&output->pending.damage, &n);
+		for (int i = 0; i < n; ++i) {
+			area += (int64_t)(rects[i].x2 - rects[i].x1) *
+				(rects[i].y2 - rects[i].y1);
+		}
+	} else {
+		area = (int64_t)output->width * output->height;
+	}
+	trace_counter("wlr_output_damage_area", output->name, area);
+}
+
 bool wlr_output_commit(struct wlr_output *output) {
 	if (output->frame_pending) {
 		wlr_log(WLR_ERROR, "Tried to commit when a frame is pending");
@@ -475,13 +505,18 @@ bool wlr_output_commit(struct wlr_output *output) {
 	struct timespec now;
 	clock_gettime(CLOCK_MONOTONIC, &now);
 
+	output->commit_seq++;
+
 	struct wlr_output_event_precommit event = {
 		.output = output,
 		.when = &now,
 	};
 	wlr_signal_emit_safe(&output->events.precommit, &event);
 
+	output_trace_damage(output);
+
 	if (!output->impl->commit(output)) {
+		output->commit_seq--;
 		output_state_clear(&output->pending);
 		return false;
 	}
@@ -495,6 +530,7 @@ bool wlr_output_commit(struct wlr_output *output) {
 	}
 
 	wlr_signal_emit_safe(&output->events.commit, output);
+	trace_output_commit(output);
 
 	output->frame_pending = true;
 	output->needs_frame = false;
@@ -569,6 +605,8 @@ void wlr_output_send_present(struct wlr_output *output,
 	}
 
 	event->output = output;
+	// Only one commit can be in flight, so this is always the last one
+	event->commit_seq = output->commit_seq;
 
 	struct timespec now;
 	if (event->when == NULL) {
@@ -582,6 +620,9 @@ void wlr_output_send_present(struct wlr_output *output,
 		event->when = &now;
 	}
 
+	clockid_t clock = wlr_backend_get_presentation_clock(output->backend);
+	trace_output_present(output, clock == CLOCK_MONOTONIC ? event->when : NULL);
+
 	wlr_signal_emit_safe(&output->events.present, event);
 }
 
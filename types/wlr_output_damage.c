@@ -181,11 +181,15 @@ void wlr_output_damage_add(struct wlr_output_damage *output_damage,
 	int width, height;
 	wlr_output_transformed_resolution(output_damage->output, &width, &height);
 
-	pixman_region32_union(&output_damage->current, &output_damage->current,
-		damage);
-	pixman_region32_intersect_rect(&output_damage->current,
-		&output_damage->current, 0, 0, width, height);
-	wlr_output_schedule_frame(output_damage->output);
+	pixman_region32_t clipped;
+	pixman_region32_init(&clipped);
+	pixman_region32_intersect_rect(&clipped, damage, 0, 0, width, height);
+	if (pixman_region32_not_empty(&clipped)) {
+		pixman_region32_union(&output_damage->current,
+			&output_damage->current, &clipped);
+		wlr_output_schedule_frame(output_damage->output);
+	}
+	pixman_region32_fini(&clipped);
 }
 
 void wlr_output_damage_add_whole(struct wlr_output_damage *output_damage) {
@@ -203,9 +207,13 @@ void wlr_output_damage_add_box(struct wlr_output_damage *output_damage,
 	int width, height;
 	wlr_output_transformed_resolution(output_damage->output, &width, &height);
 
+	struct wlr_box output_box = { .width = width, .height = height };
+	struct wlr_box clipped;
+	if (!wlr_box_intersection(&clipped, &output_box, box)) {
+		return;
+	}
+
 	pixman_region32_union_rect(&output_damage->current, &output_damage->current,
-		box->x, box->y, box->width, box->height);
-	pixman_region32_intersect_rect(&output_damage->current,
-		&output_damage->current, 0, 0, width, height);
+		clipped.x, clipped.y, clipped.width, clipped.height);
 	wlr_output_schedule_frame(output_damage->output);
 }
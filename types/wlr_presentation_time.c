@@ -1,6 +1,7 @@
 #define _POSIX_C_SOURCE 199309L
 #include <assert.h>
 #include <stdlib.h>
+#include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_presentation_time.h>
 #include <wlr/types/wlr_surface.h>
 #include <wlr/backend.h>
@@ -16,11 +17,30 @@ static struct wlr_presentation_feedback *presentation_feedback_from_resource(
 	return wl_resource_get_user_data(resource);
 }
 
+static void feedback_unset_surface(struct wlr_presentation_feedback *feedback) {
+	if (feedback->surface == NULL) {
+		return;
+	}
+	feedback->surface = NULL;
+	wl_list_remove(&feedback->surface_commit.link);
+	wl_list_remove(&feedback->surface_destroy.link);
+}
+
+static void feedback_unset_output(struct wlr_presentation_feedback *feedback) {
+	if (feedback->output == NULL) {
+		return;
+	}
+	feedback->output = NULL;
+	wl_list_remove(&feedback->output_precommit.link);
+	wl_list_remove(&feedback->output_present.link);
+	wl_list_remove(&feedback->output_destroy.link);
+}
+
 static void feedback_handle_resource_destroy(struct wl_resource *resource) {
 	struct wlr_presentation_feedback *feedback =
 		presentation_feedback_from_resource(resource);
-	wl_list_remove(&feedback->surface_commit.link);
-	wl_list_remove(&feedback->surface_destroy.link);
+	feedback_unset_surface(feedback);
+	feedback_unset_output(feedback);
 	wl_list_remove(&feedback->link);
 	free(feedback);
 }
@@ -60,6 +80,11 @@ static void feedback_handle_surface_commit(struct wl_listener *listener,
 	struct wlr_presentation_feedback *feedback =
 		wl_container_of(listener, feedback, surface_commit);
 
+	if (feedback->sampled) {
+		// The content will be presented, a new commit doesn't change that
+		return;
+	}
+
 	if (feedback->committed) {
 		// The content update has been superseded
 		feedback_send_discarded(feedback);
@@ -72,6 +97,75 @@ static void feedback_handle_surface_destroy(struct wl_listener *listener,
 		void *data) {
 	struct wlr_presentation_feedback *feedback =
 		wl_container_of(listener, feedback, surface_destroy);
+	if (feedback->sampled) {
+		// Still wait for the output commit containing the content
+		feedback_unset_surface(feedback);
+	} else {
+		feedback_send_discarded(feedback);
+	}
+}
+
+static void feedback_handle_output_precommit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_presentation_feedback *feedback =
+		wl_container_of(listener, feedback, output_precommit);
+	struct wlr_output *output = feedback->output;
+
+	if (feedback->output_committed &&
+			feedback->output_commit_seq != output->commit_seq) {
+		// Already included in a successful commit
+		return;
+	}
+	// If the previous commit failed, the sequence number has been reverted
+	// and this is a new attempt (e.g. rendering after a failed scan-out):
+	// latch it again
+	feedback->output_committed = true;
+	feedback->output_commit_seq = output->commit_seq;
+
+	// The content is only presented zero-copy if the surface's own buffer is
+	// scanned out, other surfaces may be composited into the output buffer
+	struct wlr_output_state *pending = &output->pending;
+	feedback->zero_copy = feedback->surface != NULL &&
+		feedback->surface->buffer != NULL &&
+		(pending->committed & WLR_OUTPUT_STATE_BUFFER) &&
+		pending->buffer_type == WLR_OUTPUT_STATE_BUFFER_SCANOUT &&
+		pending->buffer == feedback->surface->buffer;
+}
+
+static void feedback_handle_output_present(struct wl_listener *listener,
+		void *data) {
+	struct wlr_presentation_feedback *feedback =
+		wl_container_of(listener, feedback, output_present);
+	struct wlr_output_event_present *output_event = data;
+
+	if (!feedback->output_committed) {
+		return;
+	}
+
+	if (output_event->commit_seq != feedback->output_commit_seq) {
+		// A later commit has been presented instead
+		feedback_send_discarded(feedback);
+		return;
+	}
+
+	struct wlr_presentation_event event = {
+		.output = output_event->output,
+		.tv_sec = (uint64_t)output_event->when->tv_sec,
+		.tv_nsec = (uint32_t)output_event->when->tv_nsec,
+		.refresh = (uint32_t)output_event->refresh,
+		.seq = (uint64_t)output_event->seq,
+		.flags = output_event->flags,
+	};
+	if (!feedback->zero_copy) {
+		event.flags &= ~WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY;
+	}
+	feedback_send_presented(feedback, &event);
+}
+
+static void feedback_handle_output_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_presentation_feedback *feedback =
+		wl_container_of(listener, feedback, output_destroy);
 	feedback_send_discarded(feedback);
 }
 
@@ -216,8 +310,35 @@ void wlr_presentation_send_surface_presented(
 	struct wlr_presentation_feedback *feedback, *feedback_tmp;
 	wl_list_for_each_safe(feedback, feedback_tmp,
 			&presentation->feedbacks, link) {
-		if (feedback->surface == surface && feedback->committed) {
+		if (feedback->surface == surface && feedback->committed &&
+				!feedback->sampled) {
 			feedback_send_presented(feedback, event);
 		}
 	}
 }
+
+void wlr_presentation_surface_sampled_on_output(
+		struct wlr_presentation *presentation, struct wlr_surface *surface,
+		struct wlr_output *output) {
+	struct wlr_presentation_feedback *feedback;
+	wl_list_for_each(feedback, &presentation->feedbacks, link) {
+		if (feedback->surface != surface || !feedback->committed) {
+			continue;
+		}
+		if (feedback->sampled) {
+			// Already waiting for a commit, maybe on another output
+			continue;
+		}
+
+		feedback->sampled = true;
+		feedback->output = output;
+		feedback->output_committed = false;
+
+		feedback->output_precommit.notify = feedback_handle_output_precommit;
+		wl_signal_add(&output->events.precommit, &feedback->output_precommit);
+		feedback->output_present.notify = feedback_handle_output_present;
+		wl_signal_add(&output->events.present, &feedback->output_present);
+		feedback->output_destroy.notify = feedback_handle_output_destroy;
+		wl_signal_add(&output->events.destroy, &feedback->output_destroy);
+	}
+}
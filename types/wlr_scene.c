@@ -0,0 +1,1240 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlr/backend.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/types/wlr_buffer.h>
+#include <wlr/types/wlr_matrix.h>
+#include <wlr/types/wlr_output_damage.h>
+#include <wlr/types/wlr_scene.h>
+#include <wlr/types/wlr_surface.h>
+#include <wlr/util/log.h>
+#include <wlr/util/region.h>
+#include "util/signal.h"
+
+static struct wlr_scene *scene_root_from_node(struct wlr_scene_node *node) {
+	assert(node->type == WLR_SCENE_NODE_ROOT);
+	return (struct wlr_scene *)node;
+}
+
+struct wlr_scene_surface *wlr_scene_surface_from_node(
+		struct wlr_scene_node *node) {
+	assert(node->type == WLR_SCENE_NODE_SURFACE);
+	return (struct wlr_scene_surface *)node;
+}
+
+static struct wlr_scene_rect *scene_rect_from_node(
+		struct wlr_scene_node *node) {
+	assert(node->type == WLR_SCENE_NODE_RECT);
+	return (struct wlr_scene_rect *)node;
+}
+
+static struct wlr_scene_buffer *scene_buffer_from_node(
+		struct wlr_scene_node *node) {
+	assert(node->type == WLR_SCENE_NODE_BUFFER);
+	return (struct wlr_scene_buffer *)node;
+}
+
+static struct wlr_scene *scene_node_get_root(struct wlr_scene_node *node) {
+	while (node->parent != NULL) {
+		node = node->parent;
+	}
+	return scene_root_from_node(node);
+}
+
+static void scene_node_state_init(struct wlr_scene_node_state *state) {
+	wl_list_init(&state->children);
+	wl_list_init(&state->link);
+	state->enabled = true;
+}
+
+static void scene_node_init(struct wlr_scene_node *node,
+		enum wlr_scene_node_type type, struct wlr_scene_node *parent) {
+	assert(type == WLR_SCENE_NODE_ROOT || parent != NULL);
+
+	node->type = type;
+	node->parent = parent;
+	scene_node_state_init(&node->state);
+	wl_signal_init(&node->events.destroy);
+
+	if (parent != NULL) {
+		wl_list_insert(parent->state.children.prev, &node->state.link);
+	}
+}
+
+static int scale_length(int length, int offset, float scale) {
+	return round((offset + length) * scale) - round(offset * scale);
+}
+
+static void scale_box(struct wlr_box *box, float scale) {
+	box->width = scale_length(box->width, box->x, scale);
+	box->height = scale_length(box->height, box->y, scale);
+	box->x = round(box->x * scale);
+	box->y = round(box->y * scale);
+}
+
+static void scene_node_get_size(struct wlr_scene_node *node,
+		int *width, int *height) {
+	*width = 0;
+	*height = 0;
+
+	switch (node->type) {
+	case WLR_SCENE_NODE_ROOT:
+	case WLR_SCENE_NODE_TREE:
+		break;
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(node);
+		*width = scene_surface->surface->current.width;
+		*height = scene_surface->surface->current.height;
+		break;
+	case WLR_SCENE_NODE_RECT:;
+		struct wlr_scene_rect *scene_rect = scene_rect_from_node(node);
+		*width = scene_rect->width;
+		*height = scene_rect->height;
+		break;
+	case WLR_SCENE_NODE_BUFFER:;
+		struct wlr_scene_buffer *scene_buffer = scene_buffer_from_node(node);
+		wlr_texture_get_size(scene_buffer->buffer->texture, width, height);
+		break;
+	}
+}
+
+/**
+ * Damage a box in scene coordinates on all outputs.
+ */
+static void scene_damage_box(struct wlr_scene *scene,
+		const struct wlr_box *box) {
+	struct wlr_scene_output *scene_output;
+	wl_list_for_each(scene_output, &scene->outputs, link) {
+		struct wlr_box output_box = *box;
+		output_box.x -= scene_output->x;
+		output_box.y -= scene_output->y;
+		scale_box(&output_box, scene_output->output->scale);
+		wlr_output_damage_add_box(scene_output->damage, &output_box);
+	}
+}
+
+static void _scene_node_damage_whole(struct wlr_scene_node *node,
+		struct wlr_scene *scene, int lx, int ly) {
+	if (!node->state.enabled) {
+		return;
+	}
+
+	struct wlr_scene_node *child;
+	wl_list_for_each(child, &node->state.children, state.link) {
+		_scene_node_damage_whole(child, scene,
+			lx + child->state.x, ly + child->state.y);
+	}
+
+	int width, height;
+	scene_node_get_size(node, &width, &height);
+	if (width > 0 && height > 0) {
+		struct wlr_box box = {
+			.x = lx,
+			.y = ly,
+			.width = width,
+			.height = height,
+		};
+		scene_damage_box(scene, &box);
+	}
+}
+
+static void scene_node_damage_whole(struct wlr_scene_node *node) {
+	struct wlr_scene *scene = scene_node_get_root(node);
+	if (wl_list_empty(&scene->outputs)) {
+		return;
+	}
+
+	int lx, ly;
+	if (!wlr_scene_node_coords(node, &lx, &ly)) {
+		return;
+	}
+
+	_scene_node_damage_whole(node, scene, lx, ly);
+}
+
+static void scene_node_finish(struct wlr_scene_node *node) {
+	wlr_signal_emit_safe(&node->events.destroy, NULL);
+
+	struct wlr_scene_node *child, *child_tmp;
+	wl_list_for_each_safe(child, child_tmp,
+			&node->state.children, state.link) {
+		scene_node_finish(child);
+	}
+
+	switch (node->type) {
+	case WLR_SCENE_NODE_ROOT:;
+		struct wlr_scene *scene = scene_root_from_node(node);
+		struct wlr_scene_output *scene_output, *scene_output_tmp;
+		wl_list_for_each_safe(scene_output, scene_output_tmp,
+				&scene->outputs, link) {
+			wlr_scene_output_destroy(scene_output);
+		}
+		break;
+	case WLR_SCENE_NODE_TREE:
+	case WLR_SCENE_NODE_RECT:
+		break;
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(node);
+		wl_list_remove(&scene_surface->surface_destroy.link);
+		wl_list_remove(&scene_surface->surface_commit.link);
+		break;
+	case WLR_SCENE_NODE_BUFFER:;
+		struct wlr_scene_buffer *scene_buffer = scene_buffer_from_node(node);
+		wlr_buffer_unref(scene_buffer->buffer);
+		break;
+	}
+
+	wl_list_remove(&node->state.link);
+	free(node);
+}
+
+void wlr_scene_node_destroy(struct wlr_scene_node *node) {
+	if (node == NULL) {
+		return;
+	}
+
+	scene_node_damage_whole(node);
+	scene_node_finish(node);
+}
+
+struct wlr_scene *wlr_scene_create(void) {
+	struct wlr_scene *scene = calloc(1, sizeof(struct wlr_scene));
+	if (scene == NULL) {
+		return NULL;
+	}
+	scene_node_init(&scene->node, WLR_SCENE_NODE_ROOT, NULL);
+	wl_list_init(&scene->outputs);
+	return scene;
+}
+
+struct wlr_scene_tree *wlr_scene_tree_create(struct wlr_scene_node *parent) {
+	struct wlr_scene_tree *tree = calloc(1, sizeof(struct wlr_scene_tree));
+	if (tree == NULL) {
+		return NULL;
+	}
+	scene_node_init(&tree->node, WLR_SCENE_NODE_TREE, parent);
+	return tree;
+}
+
+static void scene_surface_handle_surface_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_scene_surface *scene_surface =
+		wl_container_of(listener, scene_surface, surface_destroy);
+	wlr_scene_node_destroy(&scene_surface->node);
+}
+
+static void scene_surface_handle_surface_commit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_scene_surface *scene_surface =
+		wl_container_of(listener, scene_surface, surface_commit);
+	struct wlr_surface *surface = scene_surface->surface;
+	struct wlr_scene *scene = scene_node_get_root(&scene_surface->node);
+
+	int lx, ly;
+	if (wl_list_empty(&scene->outputs) ||
+			!wlr_scene_node_coords(&scene_surface->node, &lx, &ly)) {
+		return;
+	}
+
+	// Includes the previous bounds if the surface has shrunk or moved
+	pixman_region32_t surface_damage;
+	pixman_region32_init(&surface_damage);
+	wlr_surface_get_effective_damage(surface, &surface_damage);
+	if (!pixman_region32_not_empty(&surface_damage)) {
+		pixman_region32_fini(&surface_damage);
+		return;
+	}
+
+	pixman_region32_t damage;
+	pixman_region32_init(&damage);
+	struct wlr_scene_output *scene_output;
+	wl_list_for_each(scene_output, &scene->outputs, link) {
+		struct wlr_output *output = scene_output->output;
+
+		wlr_region_scale(&damage, &surface_damage, output->scale);
+		if (ceil(output->scale) > surface->current.scale) {
+			// When scaling up a surface, it'll become blurry so we need to
+			// expand the damage region
+			wlr_region_expand(&damage, &damage,
+				ceil(output->scale) - surface->current.scale);
+		}
+		pixman_region32_translate(&damage,
+			round((lx - scene_output->x) * output->scale),
+			round((ly - scene_output->y) * output->scale));
+		wlr_output_damage_add(scene_output->damage, &damage);
+	}
+	pixman_region32_fini(&damage);
+	pixman_region32_fini(&surface_damage);
+}
+
+struct wlr_scene_surface *wlr_scene_surface_create(struct wlr_scene_node *parent,
+		struct wlr_surface *surface) {
+	struct wlr_scene_surface *scene_surface =
+		calloc(1, sizeof(struct wlr_scene_surface));
+	if (scene_surface == NULL) {
+		return NULL;
+	}
+	scene_node_init(&scene_surface->node, WLR_SCENE_NODE_SURFACE, parent);
+
+	scene_surface->surface = surface;
+
+	scene_surface->surface_destroy.notify =
+		scene_surface_handle_surface_destroy;
+	wl_signal_add(&surface->events.destroy, &scene_surface->surface_destroy);
+
+	scene_surface->surface_commit.notify = scene_surface_handle_surface_commit;
+	wl_signal_add(&surface->events.commit, &scene_surface->surface_commit);
+
+	scene_node_damage_whole(&scene_surface->node);
+
+	return scene_surface;
+}
+
+struct wlr_scene_rect *wlr_scene_rect_create(struct wlr_scene_node *parent,
+		int width, int height, const float color[static 4]) {
+	struct wlr_scene_rect *scene_rect =
+		calloc(1, sizeof(struct wlr_scene_rect));
+	if (scene_rect == NULL) {
+		return NULL;
+	}
+	scene_node_init(&scene_rect->node, WLR_SCENE_NODE_RECT, parent);
+
+	scene_rect->width = width;
+	scene_rect->height = height;
+	memcpy(scene_rect->color, color, sizeof(scene_rect->color));
+
+	scene_node_damage_whole(&scene_rect->node);
+
+	return scene_rect;
+}
+
+void wlr_scene_rect_set_size(struct wlr_scene_rect *rect, int width,
+		int height) {
+	if (rect->width == width && rect->height == height) {
+		return;
+	}
+
+	scene_node_damage_whole(&rect->node);
+	rect->width = width;
+	rect->height = height;
+	scene_node_damage_whole(&rect->node);
+}
+
+void wlr_scene_rect_set_color(struct wlr_scene_rect *rect,
+		const float color[static 4]) {
+	if (memcmp(rect->color, color, sizeof(rect->color)) == 0) {
+		return;
+	}
+
+	memcpy(rect->color, color, sizeof(rect->color));
+	scene_node_damage_whole(&rect->node);
+}
+
+struct wlr_scene_buffer *wlr_scene_buffer_create(struct wlr_scene_node *parent,
+		struct wlr_buffer *buffer) {
+	struct wlr_scene_buffer *scene_buffer =
+		calloc(1, sizeof(struct wlr_scene_buffer));
+	if (scene_buffer == NULL) {
+		return NULL;
+	}
+	scene_node_init(&scene_buffer->node, WLR_SCENE_NODE_BUFFER, parent);
+
+	scene_buffer->buffer = wlr_buffer_ref(buffer);
+
+	scene_node_damage_whole(&scene_buffer->node);
+
+	return scene_buffer;
+}
+
+void wlr_scene_node_set_enabled(struct wlr_scene_node *node, bool enabled) {
+	if (node->state.enabled == enabled) {
+		return;
+	}
+
+	// One of these damage_whole() calls will short-circuit and be a no-op
+	scene_node_damage_whole(node);
+	node->state.enabled = enabled;
+	scene_node_damage_whole(node);
+}
+
+void wlr_scene_node_set_position(struct wlr_scene_node *node, int x, int y) {
+	if (node->state.x == x && node->state.y == y) {
+		return;
+	}
+
+	scene_node_damage_whole(node);
+	node->state.x = x;
+	node->state.y = y;
+	scene_node_damage_whole(node);
+}
+
+void wlr_scene_node_place_above(struct wlr_scene_node *node,
+		struct wlr_scene_node *sibling) {
+	assert(node != sibling);
+	assert(node->parent == sibling->parent);
+
+	if (node->state.link.prev == &sibling->state.link) {
+		return;
+	}
+
+	wl_list_remove(&node->state.link);
+	wl_list_insert(&sibling->state.link, &node->state.link);
+
+	// Only the overlap between the two nodes changes, which is contained in
+	// the node's bounds
+	scene_node_damage_whole(node);
+}
+
+void wlr_scene_node_place_below(struct wlr_scene_node *node,
+		struct wlr_scene_node *sibling) {
+	assert(node != sibling);
+	assert(node->parent == sibling->parent);
+
+	if (node->state.link.next == &sibling->state.link) {
+		return;
+	}
+
+	wl_list_remove(&node->state.link);
+	wl_list_insert(sibling->state.link.prev, &node->state.link);
+
+	scene_node_damage_whole(node);
+}
+
+void wlr_scene_node_raise_to_top(struct wlr_scene_node *node) {
+	struct wlr_scene_node *current_top = wl_container_of(
+		node->parent->state.children.prev, current_top, state.link);
+	if (node == current_top) {
+		return;
+	}
+	wlr_scene_node_place_above(node, current_top);
+}
+
+void wlr_scene_node_lower_to_bottom(struct wlr_scene_node *node) {
+	struct wlr_scene_node *current_bottom = wl_container_of(
+		node->parent->state.children.next, current_bottom, state.link);
+	if (node == current_bottom) {
+		return;
+	}
+	wlr_scene_node_place_below(node, current_bottom);
+}
+
+void wlr_scene_node_reparent(struct wlr_scene_node *node,
+		struct wlr_scene_node *new_parent) {
+	assert(node->type != WLR_SCENE_NODE_ROOT && new_parent != NULL);
+
+	if (node->parent == new_parent) {
+		return;
+	}
+
+	// Ensure that a node cannot become its own ancestor
+	for (struct wlr_scene_node *ancestor = new_parent; ancestor != NULL;
+			ancestor = ancestor->parent) {
+		assert(ancestor != node);
+	}
+
+	scene_node_damage_whole(node);
+
+	wl_list_remove(&node->state.link);
+	node->parent = new_parent;
+	wl_list_insert(new_parent->state.children.prev, &node->state.link);
+
+	scene_node_damage_whole(node);
+}
+
+bool wlr_scene_node_coords(struct wlr_scene_node *node,
+		int *lx_ptr, int *ly_ptr) {
+	int lx = 0, ly = 0;
+	bool enabled = true;
+	while (node != NULL) {
+		lx += node->state.x;
+		ly += node->state.y;
+		enabled = enabled && node->state.enabled;
+		node = node->parent;
+	}
+
+	*lx_ptr = lx;
+	*ly_ptr = ly;
+	return enabled;
+}
+
+static void scene_node_for_each_surface(struct wlr_scene_node *node,
+		int lx, int ly, wlr_surface_iterator_func_t user_iterator,
+		void *user_data) {
+	if (!node->state.enabled) {
+		return;
+	}
+
+	lx += node->state.x;
+	ly += node->state.y;
+
+	if (node->type == WLR_SCENE_NODE_SURFACE) {
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(node);
+		user_iterator(scene_surface->surface, lx, ly, user_data);
+	}
+
+	struct wlr_scene_node *child;
+	wl_list_for_each(child, &node->state.children, state.link) {
+		scene_node_for_each_surface(child, lx, ly, user_iterator, user_data);
+	}
+}
+
+void wlr_scene_node_for_each_surface(struct wlr_scene_node *node,
+		wlr_surface_iterator_func_t user_iterator, void *user_data) {
+	int lx = 0, ly = 0;
+	if (node->parent != NULL) {
+		wlr_scene_node_coords(node->parent, &lx, &ly);
+	}
+	scene_node_for_each_surface(node, lx, ly, user_iterator, user_data);
+}
+
+struct wlr_scene_node *wlr_scene_node_at(struct wlr_scene_node *node,
+		double lx, double ly, double *nx, double *ny) {
+	if (!node->state.enabled) {
+		return NULL;
+	}
+
+	lx -= node->state.x;
+	ly -= node->state.y;
+
+	struct wlr_scene_node *child;
+	wl_list_for_each_reverse(child, &node->state.children, state.link) {
+		struct wlr_scene_node *node_at =
+			wlr_scene_node_at(child, lx, ly, nx, ny);
+		if (node_at != NULL) {
+			return node_at;
+		}
+	}
+
+	bool intersects = false;
+	switch (node->type) {
+	case WLR_SCENE_NODE_ROOT:
+	case WLR_SCENE_NODE_TREE:
+		break;
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(node);
+		intersects = wlr_surface_point_accepts_input(scene_surface->surface,
+			lx, ly);
+		break;
+	case WLR_SCENE_NODE_RECT:
+	case WLR_SCENE_NODE_BUFFER:;
+		int width, height;
+		scene_node_get_size(node, &width, &height);
+		intersects = lx >= 0 && lx < width && ly >= 0 && ly < height;
+		break;
+	}
+
+	if (!intersects) {
+		return NULL;
+	}
+	if (nx != NULL) {
+		*nx = lx;
+	}
+	if (ny != NULL) {
+		*ny = ly;
+	}
+	return node;
+}
+
+/**
+ * A sub-tree displaying a surface and its sub-surfaces. The surface node is
+ * at the bottom, sub-surfaces follow in the surface's stacking order.
+ */
+struct scene_subsurface_tree {
+	struct wlr_scene_tree *tree;
+	struct wlr_surface *surface;
+	struct wlr_scene_surface *scene_surface;
+
+	struct scene_subsurface_tree *parent; // NULL for the root
+	struct wlr_subsurface *subsurface; // NULL for the root
+	struct wl_list children; // scene_subsurface_tree.link
+	struct wl_list link;
+
+	struct wl_listener tree_destroy;
+	struct wl_listener surface_destroy; // only for the root
+	struct wl_listener surface_commit;
+	struct wl_listener surface_new_subsurface;
+	struct wl_listener subsurface_destroy;
+	struct wl_listener subsurface_map;
+	struct wl_listener subsurface_unmap;
+};
+
+static struct scene_subsurface_tree *scene_subsurface_tree_create(
+	struct wlr_scene_node *parent, struct wlr_surface *surface,
+	struct scene_subsurface_tree *parent_tree,
+	struct wlr_subsurface *subsurface);
+
+static void subsurface_tree_handle_tree_destroy(struct wl_listener *listener,
+		void *data) {
+	struct scene_subsurface_tree *subsurface_tree =
+		wl_container_of(listener, subsurface_tree, tree_destroy);
+
+	// Children are destroyed right after their parent tree
+	struct scene_subsurface_tree *child, *child_tmp;
+	wl_list_for_each_safe(child, child_tmp, &subsurface_tree->children, link) {
+		wl_list_remove(&child->link);
+		wl_list_init(&child->link);
+	}
+
+	wl_list_remove(&subsurface_tree->link);
+	wl_list_remove(&subsurface_tree->tree_destroy.link);
+	wl_list_remove(&subsurface_tree->surface_destroy.link);
+	wl_list_remove(&subsurface_tree->surface_commit.link);
+	wl_list_remove(&subsurface_tree->surface_new_subsurface.link);
+	wl_list_remove(&subsurface_tree->subsurface_destroy.link);
+	wl_list_remove(&subsurface_tree->subsurface_map.link);
+	wl_list_remove(&subsurface_tree->subsurface_unmap.link);
+	free(subsurface_tree);
+}
+
+static void subsurface_tree_handle_surface_destroy(struct wl_listener *listener,
+		void *data) {
+	struct scene_subsurface_tree *subsurface_tree =
+		wl_container_of(listener, subsurface_tree, surface_destroy);
+	wlr_scene_node_destroy(&subsurface_tree->tree->node);
+}
+
+static struct scene_subsurface_tree *subsurface_tree_find_child(
+		struct scene_subsurface_tree *subsurface_tree,
+		struct wlr_subsurface *subsurface) {
+	struct scene_subsurface_tree *child;
+	wl_list_for_each(child, &subsurface_tree->children, link) {
+		if (child->subsurface == subsurface) {
+			return child;
+		}
+	}
+	return NULL;
+}
+
+static void subsurface_tree_reconfigure(
+		struct scene_subsurface_tree *subsurface_tree) {
+	// Raising each sub-surface in order restores the surface's stacking order,
+	// nodes already in place aren't damaged
+	struct wlr_subsurface *subsurface;
+	wl_list_for_each(subsurface, &subsurface_tree->surface->subsurfaces,
+			parent_link) {
+		struct scene_subsurface_tree *child =
+			subsurface_tree_find_child(subsurface_tree, subsurface);
+		if (child == NULL) {
+			continue;
+		}
+		wlr_scene_node_raise_to_top(&child->tree->node);
+		wlr_scene_node_set_position(&child->tree->node,
+			subsurface->current.x, subsurface->current.y);
+	}
+}
+
+static void subsurface_tree_handle_surface_commit(struct wl_listener *listener,
+		void *data) {
+	struct scene_subsurface_tree *subsurface_tree =
+		wl_container_of(listener, subsurface_tree, surface_commit);
+	subsurface_tree_reconfigure(subsurface_tree);
+}
+
+static void subsurface_tree_handle_subsurface_destroy(
+		struct wl_listener *listener, void *data) {
+	struct scene_subsurface_tree *subsurface_tree =
+		wl_container_of(listener, subsurface_tree, subsurface_destroy);
+	wlr_scene_node_destroy(&subsurface_tree->tree->node);
+}
+
+static void subsurface_tree_handle_subsurface_map(struct wl_listener *listener,
+		void *data) {
+	struct scene_subsurface_tree *subsurface_tree =
+		wl_container_of(listener, subsurface_tree, subsurface_map);
+	wlr_scene_node_set_enabled(&subsurface_tree->tree->node, true);
+}
+
+static void subsurface_tree_handle_subsurface_unmap(
+		struct wl_listener *listener, void *data) {
+	struct scene_subsurface_tree *subsurface_tree =
+		wl_container_of(listener, subsurface_tree, subsurface_unmap);
+	wlr_scene_node_set_enabled(&subsurface_tree->tree->node, false);
+}
+
+static bool subsurface_tree_add_child(
+		struct scene_subsurface_tree *subsurface_tree,
+		struct wlr_subsurface *subsurface) {
+	struct scene_subsurface_tree *child = scene_subsurface_tree_create(
+		&subsurface_tree->tree->node, subsurface->surface, subsurface_tree,
+		subsurface);
+	if (child == NULL) {
+		return false;
+	}
+
+	wlr_scene_node_set_enabled(&child->tree->node, subsurface->mapped);
+	wlr_scene_node_set_position(&child->tree->node,
+		subsurface->current.x, subsurface->current.y);
+	return true;
+}
+
+static void subsurface_tree_handle_surface_new_subsurface(
+		struct wl_listener *listener, void *data) {
+	struct scene_subsurface_tree *subsurface_tree =
+		wl_container_of(listener, subsurface_tree, surface_new_subsurface);
+	struct wlr_subsurface *subsurface = data;
+	if (!subsurface_tree_add_child(subsurface_tree, subsurface)) {
+		wlr_log(WLR_ERROR, "Failed to create sub-surface scene node");
+	}
+}
+
+static struct scene_subsurface_tree *scene_subsurface_tree_create(
+		struct wlr_scene_node *parent, struct wlr_surface *surface,
+		struct scene_subsurface_tree *parent_tree,
+		struct wlr_subsurface *subsurface) {
+	struct scene_subsurface_tree *subsurface_tree =
+		calloc(1, sizeof(struct scene_subsurface_tree));
+	if (subsurface_tree == NULL) {
+		return NULL;
+	}
+
+	subsurface_tree->tree = wlr_scene_tree_create(parent);
+	if (subsurface_tree->tree == NULL) {
+		goto error_subsurface_tree;
+	}
+
+	subsurface_tree->scene_surface =
+		wlr_scene_surface_create(&subsurface_tree->tree->node, surface);
+	if (subsurface_tree->scene_surface == NULL) {
+		goto error_scene_tree;
+	}
+
+	subsurface_tree->surface = surface;
+	subsurface_tree->parent = parent_tree;
+	subsurface_tree->subsurface = subsurface;
+	wl_list_init(&subsurface_tree->children);
+	if (parent_tree != NULL) {
+		wl_list_insert(parent_tree->children.prev, &subsurface_tree->link);
+	} else {
+		wl_list_init(&subsurface_tree->link);
+	}
+
+	subsurface_tree->tree_destroy.notify = subsurface_tree_handle_tree_destroy;
+	wl_signal_add(&subsurface_tree->tree->node.events.destroy,
+		&subsurface_tree->tree_destroy);
+
+	subsurface_tree->surface_commit.notify =
+		subsurface_tree_handle_surface_commit;
+	wl_signal_add(&surface->events.commit, &subsurface_tree->surface_commit);
+
+	subsurface_tree->surface_new_subsurface.notify =
+		subsurface_tree_handle_surface_new_subsurface;
+	wl_signal_add(&surface->events.new_subsurface,
+		&subsurface_tree->surface_new_subsurface);
+
+	if (subsurface != NULL) {
+		// Sub-surfaces are destroyed along with their surface
+		wl_list_init(&subsurface_tree->surface_destroy.link);
+
+		subsurface_tree->subsurface_destroy.notify =
+			subsurface_tree_handle_subsurface_destroy;
+		wl_signal_add(&subsurface->events.destroy,
+			&subsurface_tree->subsurface_destroy);
+
+		subsurface_tree->subsurface_map.notify =
+			subsurface_tree_handle_subsurface_map;
+		wl_signal_add(&subsurface->events.map,
+			&subsurface_tree->subsurface_map);
+
+		subsurface_tree->subsurface_unmap.notify =
+			subsurface_tree_handle_subsurface_unmap;
+		wl_signal_add(&subsurface->events.unmap,
+			&subsurface_tree->subsurface_unmap);
+	} else {
+		subsurface_tree->surface_destroy.notify =
+			subsurface_tree_handle_surface_destroy;
+		wl_signal_add(&surface->events.destroy,
+			&subsurface_tree->surface_destroy);
+
+		wl_list_init(&subsurface_tree->subsurface_destroy.link);
+		wl_list_init(&subsurface_tree->subsurface_map.link);
+		wl_list_init(&subsurface_tree->subsurface_unmap.link);
+	}
+
+	struct wlr_subsurface *child;
+	wl_list_for_each(child, &surface->subsurfaces, parent_link) {
+		if (!subsurface_tree_add_child(subsurface_tree, child)) {
+			wlr_scene_node_destroy(&subsurface_tree->tree->node);
+			return NULL;
+		}
+	}
+
+	return subsurface_tree;
+
+error_scene_tree:
+	wlr_scene_node_destroy(&subsurface_tree->tree->node);
+error_subsurface_tree:
+	free(subsurface_tree);
+	return NULL;
+}
+
+struct wlr_scene_node *wlr_scene_subsurface_tree_create(
+		struct wlr_scene_node *parent, struct wlr_surface *surface) {
+	struct scene_subsurface_tree *subsurface_tree =
+		scene_subsurface_tree_create(parent, surface, NULL, NULL);
+	if (subsurface_tree == NULL) {
+		return NULL;
+	}
+	return &subsurface_tree->tree->node;
+}
+
+static void scene_output_handle_damage_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_scene_output *scene_output =
+		wl_container_of(listener, scene_output, damage_destroy);
+	// The output damage is destroyed along with the output
+	scene_output->damage = NULL;
+	wlr_scene_output_destroy(scene_output);
+}
+
+struct wlr_scene_output *wlr_scene_output_create(struct wlr_scene *scene,
+		struct wlr_output *output) {
+	struct wlr_scene_output *scene_output =
+		calloc(1, sizeof(struct wlr_scene_output));
+	if (scene_output == NULL) {
+		return NULL;
+	}
+
+	scene_output->damage = wlr_output_damage_create(output);
+	if (scene_output->damage == NULL) {
+		free(scene_output);
+		return NULL;
+	}
+
+	scene_output->output = output;
+	scene_output->scene = scene;
+	wl_list_insert(scene->outputs.prev, &scene_output->link);
+
+	scene_output->damage_destroy.notify = scene_output_handle_damage_destroy;
+	wl_signal_add(&scene_output->damage->events.destroy,
+		&scene_output->damage_destroy);
+
+	wlr_output_damage_add_whole(scene_output->damage);
+
+	return scene_output;
+}
+
+void wlr_scene_output_destroy(struct wlr_scene_output *scene_output) {
+	if (scene_output == NULL) {
+		return;
+	}
+
+	wl_list_remove(&scene_output->link);
+	wl_list_remove(&scene_output->damage_destroy.link);
+	wlr_output_damage_destroy(scene_output->damage);
+	free(scene_output);
+}
+
+void wlr_scene_output_set_position(struct wlr_scene_output *scene_output,
+		int lx, int ly) {
+	if (scene_output->x == lx && scene_output->y == ly) {
+		return;
+	}
+
+	scene_output->x = lx;
+	scene_output->y = ly;
+	wlr_output_damage_add_whole(scene_output->damage);
+}
+
+/**
+ * A node to draw on an output. Entries are kept in rendering order.
+ */
+struct render_entry {
+	struct wlr_scene_node *node;
+	struct wlr_box box; // in output-buffer-local coordinates
+	// The parts of the node not hidden by opaque nodes above it
+	pixman_region32_t visible;
+};
+
+struct render_list {
+	struct wl_array entries; // struct render_entry
+	pixman_region32_t opaque; // covered by opaque nodes
+};
+
+static bool render_list_collect(struct wl_array *entries,
+		struct wlr_scene_output *scene_output, struct wlr_scene_node *node,
+		int lx, int ly) {
+	if (!node->state.enabled) {
+		return true;
+	}
+
+	lx += node->state.x;
+	ly += node->state.y;
+
+	int width, height;
+	scene_node_get_size(node, &width, &height);
+	if (width > 0 && height > 0) {
+		struct wlr_output *output = scene_output->output;
+		struct wlr_box box = {
+			.x = lx - scene_output->x,
+			.y = ly - scene_output->y,
+			.width = width,
+			.height = height,
+		};
+		scale_box(&box, output->scale);
+
+		struct wlr_box output_box = {0}, intersection;
+		wlr_output_transformed_resolution(output,
+			&output_box.width, &output_box.height);
+		if (wlr_box_intersection(&intersection, &box, &output_box)) {
+			struct render_entry *entry =
+				wl_array_add(entries, sizeof(struct render_entry));
+			if (entry == NULL) {
+				return false;
+			}
+			entry->node = node;
+			entry->box = box;
+			pixman_region32_init(&entry->visible);
+		}
+	}
+
+	struct wlr_scene_node *child;
+	wl_list_for_each(child, &node->state.children, state.link) {
+		if (!render_list_collect(entries, scene_output, child, lx, ly)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void render_entry_add_opaque(struct render_entry *entry, float scale,
+		pixman_region32_t *opaque) {
+	struct wlr_box *box = &entry->box;
+
+	switch (entry->node->type) {
+	case WLR_SCENE_NODE_ROOT:
+	case WLR_SCENE_NODE_TREE:
+		break;
+	case WLR_SCENE_NODE_SURFACE:;
+		// Scaled regions don't have exact edges with fractional scales
+		if (scale != floorf(scale)) {
+			break;
+		}
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(entry->node);
+		pixman_region32_t region;
+		pixman_region32_init(&region);
+		wlr_region_scale(&region, &scene_surface->surface->opaque_region,
+			scale);
+		pixman_region32_translate(&region, box->x, box->y);
+		pixman_region32_union(opaque, opaque, &region);
+		pixman_region32_fini(&region);
+		break;
+	case WLR_SCENE_NODE_RECT:;
+		struct wlr_scene_rect *scene_rect = scene_rect_from_node(entry->node);
+		if (scene_rect->color[3] >= 1.0) {
+			pixman_region32_union_rect(opaque, opaque,
+				box->x, box->y, box->width, box->height);
+		}
+		break;
+	case WLR_SCENE_NODE_BUFFER:;
+		struct wlr_scene_buffer *scene_buffer =
+			scene_buffer_from_node(entry->node);
+		if (wlr_texture_is_opaque(scene_buffer->buffer->texture)) {
+			pixman_region32_union_rect(opaque, opaque,
+				box->x, box->y, box->width, box->height);
+		}
+		break;
+	}
+}
+
+static void render_list_finish(struct render_list *list) {
+	struct render_entry *entry;
+	wl_array_for_each(entry, &list->entries) {
+		pixman_region32_fini(&entry->visible);
+	}
+	wl_array_release(&list->entries);
+	pixman_region32_fini(&list->opaque);
+}
+
+/**
+ * Collect the nodes displayed on the output and compute which parts of them
+ * are visible, walking from the top so that nodes hidden by opaque nodes can
+ * be culled.
+ */
+static bool render_list_init(struct render_list *list,
+		struct wlr_scene_output *scene_output) {
+	wl_array_init(&list->entries);
+	pixman_region32_init(&list->opaque);
+
+	if (!render_list_collect(&list->entries, scene_output,
+			&scene_output->scene->node, 0, 0)) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		render_list_finish(list);
+		return false;
+	}
+
+	struct wlr_output *output = scene_output->output;
+	int width, height;
+	wlr_output_transformed_resolution(output, &width, &height);
+
+	struct render_entry *entries = list->entries.data;
+	size_t len = list->entries.size / sizeof(struct render_entry);
+	for (size_t i = len; i-- > 0;) {
+		struct render_entry *entry = &entries[i];
+		pixman_region32_union_rect(&entry->visible, &entry->visible,
+			entry->box.x, entry->box.y, entry->box.width, entry->box.height);
+		pixman_region32_intersect_rect(&entry->visible, &entry->visible,
+			0, 0, width, height);
+		pixman_region32_subtract(&entry->visible, &entry->visible,
+			&list->opaque);
+		if (pixman_region32_not_empty(&entry->visible)) {
+			render_entry_add_opaque(entry, output->scale, &list->opaque);
+		}
+	}
+
+	return true;
+}
+
+static void scissor_output(struct wlr_output *output, pixman_box32_t *rect) {
+	struct wlr_renderer *renderer = wlr_backend_get_renderer(output->backend);
+	assert(renderer);
+
+	struct wlr_box box = {
+		.x = rect->x1,
+		.y = rect->y1,
+		.width = rect->x2 - rect->x1,
+		.height = rect->y2 - rect->y1,
+	};
+
+	int ow, oh;
+	wlr_output_transformed_resolution(output, &ow, &oh);
+
+	enum wl_output_transform transform =
+		wlr_output_transform_invert(output->transform);
+	wlr_box_transform(&box, &box, transform, ow, oh);
+
+	wlr_renderer_scissor(renderer, &box);
+}
+
+static void render_entry(struct wlr_output *output,
+		struct render_entry *entry, pixman_region32_t *output_damage) {
+	struct wlr_renderer *renderer = wlr_backend_get_renderer(output->backend);
+	assert(renderer);
+
+	// Draw each node once per visible damaged rectangle
+	pixman_region32_t damage;
+	pixman_region32_init(&damage);
+	pixman_region32_intersect(&damage, &entry->visible, output_damage);
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(&damage, &nrects);
+	if (nrects == 0) {
+		goto damage_finish;
+	}
+
+	float matrix[9];
+	struct wlr_texture *texture = NULL;
+	enum wl_output_transform transform = WL_OUTPUT_TRANSFORM_NORMAL;
+	switch (entry->node->type) {
+	case WLR_SCENE_NODE_ROOT:
+	case WLR_SCENE_NODE_TREE:
+		break;
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(entry->node);
+		texture = wlr_surface_get_texture(scene_surface->surface);
+		transform = wlr_output_transform_invert(
+			scene_surface->surface->current.transform);
+		break;
+	case WLR_SCENE_NODE_RECT:;
+		struct wlr_scene_rect *scene_rect = scene_rect_from_node(entry->node);
+		wlr_matrix_project_box(matrix, &entry->box,
+			WL_OUTPUT_TRANSFORM_NORMAL, 0.0, output->transform_matrix);
+		for (int i = 0; i < nrects; ++i) {
+			scissor_output(output, &rects[i]);
+			wlr_render_quad_with_matrix(renderer, scene_rect->color, matrix);
+		}
+		break;
+	case WLR_SCENE_NODE_BUFFER:;
+		struct wlr_scene_buffer *scene_buffer =
+			scene_buffer_from_node(entry->node);
+		texture = scene_buffer->buffer->texture;
+		break;
+	}
+
+	if (texture != NULL) {
+		wlr_matrix_project_box(matrix, &entry->box, transform, 0.0,
+			output->transform_matrix);
+		for (int i = 0; i < nrects; ++i) {
+			scissor_output(output, &rects[i]);
+			wlr_render_texture_with_matrix(renderer, texture, matrix, 1.0);
+		}
+	}
+
+damage_finish:
+	pixman_region32_fini(&damage);
+}
+
+/**
+ * Try to scan out the only node visible on the output.
+ */
+static bool scene_output_scanout(struct wlr_scene_output *scene_output,
+		struct render_list *list) {
+	struct wlr_output *output = scene_output->output;
+
+	struct render_entry *visible = NULL;
+	struct render_entry *entry;
+	wl_array_for_each(entry, &list->entries) {
+		if (!pixman_region32_not_empty(&entry->visible)) {
+			continue;
+		}
+		if (visible != NULL) {
+			return false;
+		}
+		visible = entry;
+	}
+	if (visible == NULL) {
+		return false;
+	}
+
+	int width, height;
+	wlr_output_transformed_resolution(output, &width, &height);
+	if (visible->box.x != 0 || visible->box.y != 0 ||
+			visible->box.width != width || visible->box.height != height) {
+		return false;
+	}
+
+	struct wlr_buffer *buffer = NULL;
+	switch (visible->node->type) {
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_surface *surface =
+			wlr_scene_surface_from_node(visible->node)->surface;
+		if ((float)surface->current.scale != output->scale ||
+				surface->current.transform != output->transform) {
+			return false;
+		}
+		buffer = surface->buffer;
+		break;
+	case WLR_SCENE_NODE_BUFFER:
+		if (output->transform != WL_OUTPUT_TRANSFORM_NORMAL ||
+				output->scale != 1.0) {
+			return false;
+		}
+		buffer = scene_buffer_from_node(visible->node)->buffer;
+		break;
+	default:
+		return false;
+	}
+
+	if (buffer == NULL) {
+		return false;
+	}
+	if (!wlr_output_attach_buffer(output, buffer)) {
+		return false;
+	}
+	return wlr_output_commit(output);
+}
+
+bool wlr_scene_output_commit(struct wlr_scene_output *scene_output) {
+	struct wlr_output *output = scene_output->output;
+	if (!output->enabled) {
+		return true;
+	}
+
+	struct render_list list;
+	if (!render_list_init(&list, scene_output)) {
+		return false;
+	}
+
+	bool scanout = scene_output_scanout(scene_output, &list);
+	if (scanout != scene_output->prev_scanout) {
+		wlr_log(WLR_DEBUG, "%s direct scan-out on output '%s'",
+			scanout ? "Starting" : "Stopping", output->name);
+		// The render buffers are out of date after scanning out
+		wlr_output_damage_add_whole(scene_output->damage);
+	}
+	scene_output->prev_scanout = scanout;
+	if (scanout) {
+		render_list_finish(&list);
+		return true;
+	}
+
+	struct wlr_renderer *renderer = wlr_backend_get_renderer(output->backend);
+	assert(renderer);
+
+	bool ok = false;
+	bool needs_frame;
+	pixman_region32_t damage;
+	pixman_region32_init(&damage);
+	if (!wlr_output_damage_attach_render(scene_output->damage,
+			&needs_frame, &damage)) {
+		goto out;
+	}
+
+	if (!needs_frame) {
+		// Output isn't damaged and doesn't need a buffer swap
+		ok = true;
+		goto out;
+	}
+
+	wlr_renderer_begin(renderer, output->width, output->height);
+
+	// Only clear what isn't covered by opaque nodes
+	pixman_region32_t background;
+	pixman_region32_init(&background);
+	pixman_region32_subtract(&background, &damage, &list.opaque);
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(&background, &nrects);
+	for (int i = 0; i < nrects; ++i) {
+		scissor_output(output, &rects[i]);
+		wlr_renderer_clear(renderer, (float[4]){ 0.0, 0.0, 0.0, 1.0 });
+	}
+	pixman_region32_fini(&background);
+
+	struct render_entry *entry;
+	wl_array_for_each(entry, &list.entries) {
+		render_entry(output, entry, &damage);
+	}
+
+	wlr_output_render_software_cursors(output, &damage);
+
+	wlr_renderer_scissor(renderer, NULL);
+	wlr_renderer_end(renderer);
+
+	int tr_width, tr_height;
+	wlr_output_transformed_resolution(output, &tr_width, &tr_height);
+
+	enum wl_output_transform transform =
+		wlr_output_transform_invert(output->transform);
+
+	pixman_region32_t frame_damage;
+	pixman_region32_init(&frame_damage);
+	wlr_region_transform(&frame_damage, &scene_output->damage->current,
+		transform, tr_width, tr_height);
+	wlr_output_set_damage(output, &frame_damage);
+	pixman_region32_fini(&frame_damage);
+
+	ok = wlr_output_commit(output);
+
+out:
+	pixman_region32_fini(&damage);
+	render_list_finish(&list);
+	return ok;
+}
+
+void wlr_scene_output_send_frame_done(struct wlr_scene_output *scene_output,
+		struct timespec *now) {
+	struct render_list list;
+	if (!render_list_init(&list, scene_output)) {
+		return;
+	}
+
+	struct render_entry *entry;
+	wl_array_for_each(entry, &list.entries) {
+		if (entry->node->type != WLR_SCENE_NODE_SURFACE ||
+				!pixman_region32_not_empty(&entry->visible)) {
+			continue;
+		}
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(entry->node);
+		wlr_surface_send_frame_done(scene_surface->surface, now);
+	}
+
+	render_list_finish(&list);
+}
@@ -1,6 +1,10 @@
 #include <assert.h>
+#include <drm_fourcc.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <wlr/render/interface.h>
 #include <wlr/render/wlr_renderer.h>
+#include <wlr/types/wlr_linux_dmabuf_v1.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_screencopy_v1.h>
 #include <wlr/backend.h>
@@ -8,10 +12,108 @@
 #include "wlr-screencopy-unstable-v1-protocol.h"
 #include "util/signal.h"
 
-#define SCREENCOPY_MANAGER_VERSION 1
+#define SCREENCOPY_MANAGER_VERSION 3
+
+struct screencopy_damage {
+	struct wl_list link; // wlr_screencopy_v1_client::damages
+	struct wlr_output *output;
+	// Damage accumulated since the client's last copy, in output buffer
+	// coordinates
+	pixman_region32_t damage;
+	struct wl_listener output_precommit;
+	struct wl_listener output_destroy;
+};
 
 static const struct zwlr_screencopy_frame_v1_interface frame_impl;
 
+static struct screencopy_damage *screencopy_damage_find(
+		struct wlr_screencopy_v1_client *client,
+		struct wlr_output *output) {
+	struct screencopy_damage *damage;
+	wl_list_for_each(damage, &client->damages, link) {
+		if (damage->output == output) {
+			return damage;
+		}
+	}
+	return NULL;
+}
+
+static void screencopy_damage_destroy(struct screencopy_damage *damage) {
+	wl_list_remove(&damage->output_precommit.link);
+	wl_list_remove(&damage->output_destroy.link);
+	wl_list_remove(&damage->link);
+	pixman_region32_fini(&damage->damage);
+	free(damage);
+}
+
+static void screencopy_damage_handle_output_precommit(
+		struct wl_listener *listener, void *data) {
+	struct screencopy_damage *damage =
+		wl_container_of(listener, damage, output_precommit);
+	struct wlr_output *output = damage->output;
+
+	if (!(output->pending.committed & WLR_OUTPUT_STATE_BUFFER)) {
+		return;
+	}
+
+	if (output->pending.committed & WLR_OUTPUT_STATE_DAMAGE) {
+		pixman_region32_union(&damage->damage, &damage->damage,
+			&output->pending.damage);
+	} else {
+		pixman_region32_union_rect(&damage->damage, &damage->damage,
+			0, 0, output->width, output->height);
+	}
+}
+
+static void screencopy_damage_handle_output_destroy(
+		struct wl_listener *listener, void *data) {
+	struct screencopy_damage *damage =
+		wl_container_of(listener, damage, output_destroy);
+	screencopy_damage_destroy(damage);
+}
+
+static struct screencopy_damage *screencopy_damage_get_or_create(
+		struct wlr_screencopy_v1_client *client,
+		struct wlr_output *output) {
+	struct screencopy_damage *damage = screencopy_damage_find(client, output);
+	if (damage != NULL) {
+		return damage;
+	}
+
+	damage = calloc(1, sizeof(struct screencopy_damage));
+	if (damage == NULL) {
+		return NULL;
+	}
+	damage->output = output;
+	// Nothing has been copied yet, the whole output needs to be
+	pixman_region32_init_rect(&damage->damage, 0, 0,
+		output->width, output->height);
+	wl_list_insert(&client->damages, &damage->link);
+
+	wl_signal_add(&output->events.precommit, &damage->output_precommit);
+	damage->output_precommit.notify =
+		screencopy_damage_handle_output_precommit;
+
+	wl_signal_add(&output->events.destroy, &damage->output_destroy);
+	damage->output_destroy.notify = screencopy_damage_handle_output_destroy;
+
+	return damage;
+}
+
+static void client_unref(struct wlr_screencopy_v1_client *client) {
+	assert(client->ref > 0);
+	if (--client->ref != 0) {
+		return;
+	}
+
+	struct screencopy_damage *damage, *tmp_damage;
+	wl_list_for_each_safe(damage, tmp_damage, &client->damages, link) {
+		screencopy_damage_destroy(damage);
+	}
+
+	free(client);
+}
+
 static struct wlr_screencopy_frame_v1 *frame_from_resource(
 		struct wl_resource *resource) {
 	assert(wl_resource_instance_of(resource,
@@ -23,18 +125,82 @@ static void frame_destroy(struct wlr_screencopy_frame_v1 *frame) {
 	if (frame == NULL) {
 		return;
 	}
-	wlr_output_lock_attach_render(frame->output, false);
 	if (frame->cursor_locked) {
 		wlr_output_lock_software_cursors(frame->output, false);
 	}
 	wl_list_remove(&frame->link);
 	wl_list_remove(&frame->output_precommit.link);
 	wl_list_remove(&frame->buffer_destroy.link);
+	if (frame->fence_source != NULL) {
+		wl_event_source_remove(frame->fence_source);
+		close(frame->fence_fd);
+	}
 	// Make the frame resource inert
 	wl_resource_set_user_data(frame->resource, NULL);
+	client_unref(frame->client);
 	free(frame);
 }
 
+// copy_with_damage copies the whole frame too, damage is only reported to
+// the client: it may rotate between several buffers
+static bool frame_shm_copy(struct wlr_screencopy_frame_v1 *frame,
+		struct wlr_renderer *renderer, uint32_t *flags) {
+	struct wl_shm_buffer *buffer = frame->buffer;
+	int32_t stride = wl_shm_buffer_get_stride(buffer);
+
+	wl_shm_buffer_begin_access(buffer);
+	void *data = wl_shm_buffer_get_data(buffer);
+	bool ok = wlr_renderer_read_pixels(renderer, frame->format, flags, stride,
+		frame->box.width, frame->box.height, frame->box.x, frame->box.y,
+		0, 0, data);
+	wl_shm_buffer_end_access(buffer);
+	return ok;
+}
+
+static bool frame_dma_copy(struct wlr_screencopy_frame_v1 *frame,
+		struct wlr_renderer *renderer, uint32_t *flags) {
+	struct wlr_dmabuf_attributes *attribs = &frame->dma_buffer->attributes;
+	struct wlr_box *box = &frame->box;
+	pixman_region32_t region;
+	pixman_region32_init_rect(&region, box->x, box->y, box->width, box->height);
+	bool ok = wlr_renderer_copy_to_dmabuf(renderer, attribs, flags, &region,
+		box->x, box->y);
+	pixman_region32_fini(&region);
+	return ok;
+}
+
+static void frame_send_ready(struct wlr_screencopy_frame_v1 *frame,
+		const struct timespec *when) {
+	time_t tv_sec = when->tv_sec;
+	uint32_t tv_sec_hi = (sizeof(tv_sec) > 4) ? tv_sec >> 32 : 0;
+	uint32_t tv_sec_lo = tv_sec & 0xFFFFFFFF;
+	zwlr_screencopy_frame_v1_send_ready(frame->resource,
+		tv_sec_hi, tv_sec_lo, when->tv_nsec);
+}
+
+static int frame_handle_fence(int fd, uint32_t mask, void *data) {
+	struct wlr_screencopy_frame_v1 *frame = data;
+	if (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) {
+		zwlr_screencopy_frame_v1_send_failed(frame->resource);
+	} else {
+		frame_send_ready(frame, &frame->ready_time);
+	}
+	frame_destroy(frame);
+	return 0;
+}
+
+static void frame_send_damage(struct wlr_screencopy_frame_v1 *frame,
+		pixman_region32_t *damage) {
+	int n;
+	pixman_box32_t *rects = pixman_region32_rectangles(damage, &n);
+	for (int i = 0; i < n; ++i) {
+		pixman_box32_t *r = &rects[i];
+		zwlr_screencopy_frame_v1_send_damage(frame->resource,
+			r->x1 - frame->box.x, r->y1 - frame->box.y,
+			r->x2 - r->x1, r->y2 - r->y1);
+	}
+}
+
 static void frame_handle_output_precommit(struct wl_listener *listener,
 		void *_data) {
 	struct wlr_screencopy_frame_v1 *frame =
@@ -48,28 +214,50 @@ static void frame_handle_output_precommit(struct wl_listener *listener,
 		return;
 	}
 
-	wl_list_remove(&frame->output_precommit.link);
-	wl_list_init(&frame->output_precommit.link);
-
 	int x = frame->box.x;
 	int y = frame->box.y;
 
-	struct wl_shm_buffer *buffer = frame->buffer;
-	assert(buffer != NULL);
+	pixman_region32_t damage;
+	pixman_region32_init_rect(&damage, x, y,
+		frame->box.width, frame->box.height);
+	struct screencopy_damage *sc_damage = NULL;
+	if (frame->with_damage) {
+		sc_damage = screencopy_damage_find(frame->client, output);
+		if (sc_damage != NULL) {
+			pixman_region32_intersect(&damage, &damage, &sc_damage->damage);
+		}
+		if (!pixman_region32_not_empty(&damage)) {
+			// Nothing changed in the captured region, wait for the next frame
+			pixman_region32_fini(&damage);
+			return;
+		}
+	}
 
-	enum wl_shm_format fmt = wl_shm_buffer_get_format(buffer);
-	int32_t width = wl_shm_buffer_get_width(buffer);
-	int32_t height = wl_shm_buffer_get_height(buffer);
-	int32_t stride = wl_shm_buffer_get_stride(buffer);
+	wl_list_remove(&frame->output_precommit.link);
+	wl_list_init(&frame->output_precommit.link);
 
-	wl_shm_buffer_begin_access(buffer);
-	void *data = wl_shm_buffer_get_data(buffer);
+	// If a client buffer is about to be scanned out, read from it
+	bool scanout =
+		output->pending.buffer_type == WLR_OUTPUT_STATE_BUFFER_SCANOUT;
 	uint32_t flags = 0;
-	bool ok = wlr_renderer_read_pixels(renderer, fmt, &flags, stride,
-		width, height, x, y, 0, 0, data);
-	wl_shm_buffer_end_access(buffer);
+	bool ok = true;
+	if (scanout) {
+		ok = wlr_renderer_bind_buffer(renderer, output->pending.buffer);
+	}
+	if (!ok) {
+		wlr_log(WLR_ERROR, "Failed to capture scanned out buffer");
+	} else if (frame->dma_buffer != NULL) {
+		ok = frame_dma_copy(frame, renderer, &flags);
+	} else {
+		assert(frame->buffer != NULL);
+		ok = frame_shm_copy(frame, renderer, &flags);
+	}
+	if (scanout) {
+		wlr_renderer_bind_buffer(renderer, NULL);
+	}
 
 	if (!ok) {
+		pixman_region32_fini(&damage);
 		zwlr_screencopy_frame_v1_send_failed(frame->resource);
 		frame_destroy(frame);
 		return;
@@ -77,12 +265,34 @@ static void frame_handle_output_precommit(struct wl_listener *listener,
 
 	zwlr_screencopy_frame_v1_send_flags(frame->resource, flags);
 
-	time_t tv_sec = event->when->tv_sec;
-	uint32_t tv_sec_hi = (sizeof(tv_sec) > 4) ? tv_sec >> 32 : 0;
-	uint32_t tv_sec_lo = tv_sec & 0xFFFFFFFF;
-	zwlr_screencopy_frame_v1_send_ready(frame->resource,
-		tv_sec_hi, tv_sec_lo, event->when->tv_nsec);
+	if (frame->with_damage) {
+		frame_send_damage(frame, &damage);
+		if (sc_damage != NULL) {
+			pixman_region32_subtract(&sc_damage->damage, &sc_damage->damage,
+				&damage);
+		}
+	}
+	pixman_region32_fini(&damage);
+
+	if (frame->dma_buffer != NULL) {
+		// Don't block on the GPU, send the ready event once the copy is done.
+		// Without a fence, rely on implicit synchronization.
+		int fence_fd = wlr_renderer_export_fence(renderer);
+		if (fence_fd >= 0) {
+			struct wl_event_loop *event_loop = wl_display_get_event_loop(
+				wl_client_get_display(wl_resource_get_client(frame->resource)));
+			frame->fence_source = wl_event_loop_add_fd(event_loop, fence_fd,
+				WL_EVENT_READABLE, frame_handle_fence, frame);
+			if (frame->fence_source != NULL) {
+				frame->fence_fd = fence_fd;
+				frame->ready_time = *event->when;
+				return;
+			}
+			close(fence_fd);
+		}
+	}
 
+	frame_send_ready(frame, event->when);
 	frame_destroy(frame);
 }
 
@@ -94,9 +304,8 @@ static void frame_handle_buffer_destroy(struct wl_listener *listener,
 	frame_destroy(frame);
 }
 
-static void frame_handle_copy(struct wl_client *client,
-		struct wl_resource *frame_resource,
-		struct wl_resource *buffer_resource) {
+static void frame_copy(struct wl_resource *frame_resource,
+		struct wl_resource *buffer_resource, bool with_damage) {
 	struct wlr_screencopy_frame_v1 *frame = frame_from_resource(frame_resource);
 	if (frame == NULL) {
 		return;
@@ -105,34 +314,59 @@ static void frame_handle_copy(struct wl_client *client,
 	struct wlr_output *output = frame->output;
 
 	struct wl_shm_buffer *buffer = wl_shm_buffer_get(buffer_resource);
-	if (buffer == NULL) {
+	struct wlr_dmabuf_v1_buffer *dma_buffer = NULL;
+	if (buffer != NULL) {
+		enum wl_shm_format fmt = wl_shm_buffer_get_format(buffer);
+		int32_t width = wl_shm_buffer_get_width(buffer);
+		int32_t height = wl_shm_buffer_get_height(buffer);
+		int32_t stride = wl_shm_buffer_get_stride(buffer);
+		if (fmt != frame->format || width != frame->box.width ||
+				height != frame->box.height || stride != frame->stride) {
+			wl_resource_post_error(frame->resource,
+				ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
+				"invalid buffer attributes");
+			return;
+		}
+	} else if (frame->fourcc != 0 &&
+			wlr_dmabuf_v1_resource_is_buffer(buffer_resource)) {
+		dma_buffer = wlr_dmabuf_v1_buffer_from_buffer_resource(buffer_resource);
+		struct wlr_dmabuf_attributes *attribs = &dma_buffer->attributes;
+		if (attribs->format != frame->fourcc ||
+				attribs->width != frame->box.width ||
+				attribs->height != frame->box.height) {
+			wl_resource_post_error(frame->resource,
+				ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
+				"invalid buffer attributes");
+			return;
+		}
+	} else {
 		wl_resource_post_error(frame->resource,
 			ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
 			"unsupported buffer type");
 		return;
 	}
 
-	enum wl_shm_format fmt = wl_shm_buffer_get_format(buffer);
-	int32_t width = wl_shm_buffer_get_width(buffer);
-	int32_t height = wl_shm_buffer_get_height(buffer);
-	int32_t stride = wl_shm_buffer_get_stride(buffer);
-	if (fmt != frame->format || width != frame->box.width ||
-			height != frame->box.height || stride != frame->stride) {
-		wl_resource_post_error(frame->resource,
-			ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
-			"invalid buffer attributes");
-		return;
-	}
-
 	if (!wl_list_empty(&frame->output_precommit.link) ||
-			frame->buffer != NULL) {
+			frame->buffer != NULL || frame->dma_buffer != NULL) {
 		wl_resource_post_error(frame->resource,
 			ZWLR_SCREENCOPY_FRAME_V1_ERROR_ALREADY_USED,
 			"frame already used");
 		return;
 	}
 
+	// The damage tracker needs to see the output commit before the frame
+	struct screencopy_damage *damage = NULL;
+	if (with_damage) {
+		damage = screencopy_damage_get_or_create(frame->client, output);
+		if (damage == NULL) {
+			wl_client_post_no_memory(wl_resource_get_client(frame_resource));
+			return;
+		}
+	}
+
 	frame->buffer = buffer;
+	frame->dma_buffer = dma_buffer;
+	frame->with_damage = with_damage;
 
 	wl_signal_add(&output->events.precommit, &frame->output_precommit);
 	frame->output_precommit.notify = frame_handle_output_precommit;
@@ -140,17 +374,42 @@ static void frame_handle_copy(struct wl_client *client,
 	wl_resource_add_destroy_listener(buffer_resource, &frame->buffer_destroy);
 	frame->buffer_destroy.notify = frame_handle_buffer_destroy;
 
-	// Schedule a buffer commit
-	output->needs_frame = true;
-	wlr_output_schedule_frame(output);
+	// Schedule a buffer commit, unless the frame waits for damage which
+	// hasn't happened yet
+	bool damaged = true;
+	if (damage != NULL) {
+		pixman_region32_t region;
+		pixman_region32_init(&region);
+		pixman_region32_intersect_rect(&region, &damage->damage,
+			frame->box.x, frame->box.y, frame->box.width, frame->box.height);
+		damaged = pixman_region32_not_empty(&region);
+		pixman_region32_fini(&region);
+	}
+	if (damaged) {
+		output->needs_frame = true;
+		wlr_output_schedule_frame(output);
+	}
 
-	wlr_output_lock_attach_render(output, true);
+	// Direct scanout is left enabled, the scanned out buffer is captured
+	// instead of the output's. Software cursors prevent direct scanout.
 	if (frame->overlay_cursor) {
 		wlr_output_lock_software_cursors(output, true);
 		frame->cursor_locked = true;
 	}
 }
 
+static void frame_handle_copy(struct wl_client *client,
+		struct wl_resource *frame_resource,
+		struct wl_resource *buffer_resource) {
+	frame_copy(frame_resource, buffer_resource, false);
+}
+
+static void frame_handle_copy_with_damage(struct wl_client *client,
+		struct wl_resource *frame_resource,
+		struct wl_resource *buffer_resource) {
+	frame_copy(frame_resource, buffer_resource, true);
+}
+
 static void frame_handle_destroy(struct wl_client *client,
 		struct wl_resource *frame_resource) {
 	wl_resource_destroy(frame_resource);
@@ -159,6 +418,7 @@ static void frame_handle_destroy(struct wl_client *client,
 static const struct zwlr_screencopy_frame_v1_interface frame_impl = {
 	.copy = frame_handle_copy,
 	.destroy = frame_handle_destroy,
+	.copy_with_damage = frame_handle_copy_with_damage,
 };
 
 static void frame_handle_resource_destroy(struct wl_resource *frame_resource) {
@@ -169,15 +429,46 @@ static void frame_handle_resource_destroy(struct wl_resource *frame_resource) {
 
 static const struct zwlr_screencopy_manager_v1_interface manager_impl;
 
-static struct wlr_screencopy_manager_v1 *manager_from_resource(
+static struct wlr_screencopy_v1_client *client_from_resource(
 		struct wl_resource *resource) {
 	assert(wl_resource_instance_of(resource,
 		&zwlr_screencopy_manager_v1_interface, &manager_impl));
 	return wl_resource_get_user_data(resource);
 }
 
-static void capture_output(struct wl_client *client,
-		struct wlr_screencopy_manager_v1 *manager, uint32_t version, uint32_t id,
+static uint32_t convert_wl_shm_format_to_drm(enum wl_shm_format fmt) {
+	switch (fmt) {
+	case WL_SHM_FORMAT_XRGB8888:
+		return DRM_FORMAT_XRGB8888;
+	case WL_SHM_FORMAT_ARGB8888:
+		return DRM_FORMAT_ARGB8888;
+	default:
+		return (uint32_t)fmt;
+	}
+}
+
+/**
+ * Returns the DRM format DMA-BUFs need to have to receive pixels in the given
+ * read format, or 0 if the renderer can't copy to DMA-BUFs. The format is
+ * picked among the ones advertised by wlr_linux_dmabuf_v1.
+ */
+static uint32_t get_dmabuf_format(struct wlr_renderer *renderer,
+		enum wl_shm_format read_format) {
+	if (renderer->impl->copy_to_dmabuf == NULL) {
+		return 0;
+	}
+
+	const struct wlr_drm_format_set *formats =
+		wlr_renderer_get_dmabuf_formats(renderer);
+	uint32_t fourcc = convert_wl_shm_format_to_drm(read_format);
+	if (formats == NULL || wlr_drm_format_set_get(formats, fourcc) == NULL) {
+		return 0;
+	}
+	return fourcc;
+}
+
+static void capture_output(struct wl_client *wl_client,
+		struct wlr_screencopy_v1_client *client, uint32_t version, uint32_t id,
 		int32_t overlay_cursor, struct wlr_output *output,
 		const struct wlr_box *box) {
 	struct wlr_box buffer_box = {0};
@@ -200,24 +491,27 @@ static void capture_output(struct wl_client *client,
 	struct wlr_screencopy_frame_v1 *frame =
 		calloc(1, sizeof(struct wlr_screencopy_frame_v1));
 	if (frame == NULL) {
-		wl_client_post_no_memory(client);
+		wl_client_post_no_memory(wl_client);
 		return;
 	}
-	frame->manager = manager;
+	frame->manager = client->manager;
 	frame->output = output;
 	frame->overlay_cursor = !!overlay_cursor;
 
-	frame->resource = wl_resource_create(client,
+	frame->resource = wl_resource_create(wl_client,
 		&zwlr_screencopy_frame_v1_interface, version, id);
 	if (frame->resource == NULL) {
 		free(frame);
-		wl_client_post_no_memory(client);
+		wl_client_post_no_memory(wl_client);
 		return;
 	}
 	wl_resource_set_implementation(frame->resource, &frame_impl, frame,
 		frame_handle_resource_destroy);
 
-	wl_list_insert(&manager->frames, &frame->link);
+	frame->client = client;
+	client->ref++;
+
+	wl_list_insert(&client->manager->frames, &frame->link);
 
 	wl_list_init(&frame->output_precommit.link);
 	wl_list_init(&frame->buffer_destroy.link);
@@ -233,9 +527,18 @@ static void capture_output(struct wl_client *client,
 
 	frame->box = buffer_box;
 	frame->stride = 4 * buffer_box.width; // TODO: depends on read format
+	frame->fourcc = get_dmabuf_format(renderer, frame->format);
 
 	zwlr_screencopy_frame_v1_send_buffer(frame->resource, frame->format,
 		buffer_box.width, buffer_box.height, frame->stride);
+
+	if (version >= ZWLR_SCREENCOPY_FRAME_V1_LINUX_DMABUF_SINCE_VERSION) {
+		if (frame->fourcc != 0) {
+			zwlr_screencopy_frame_v1_send_linux_dmabuf(frame->resource,
+				frame->fourcc, buffer_box.width, buffer_box.height);
+		}
+		zwlr_screencopy_frame_v1_send_buffer_done(frame->resource);
+	}
 	return;
 
 error:
@@ -243,23 +546,24 @@ error:
 	frame_destroy(frame);
 }
 
-static void manager_handle_capture_output(struct wl_client *client,
+static void manager_handle_capture_output(struct wl_client *wl_client,
 		struct wl_resource *manager_resource, uint32_t id,
 		int32_t overlay_cursor, struct wl_resource *output_resource) {
-	struct wlr_screencopy_manager_v1 *manager =
-		manager_from_resource(manager_resource);
+	struct wlr_screencopy_v1_client *client =
+		client_from_resource(manager_resource);
 	uint32_t version = wl_resource_get_version(manager_resource);
 	struct wlr_output *output = wlr_output_from_resource(output_resource);
 
-	capture_output(client, manager, version, id, overlay_cursor, output, NULL);
+	capture_output(wl_client, client, version, id, overlay_cursor, output,
+		NULL);
 }
 
-static void manager_handle_capture_output_region(struct wl_client *client,
+static void manager_handle_capture_output_region(struct wl_client *wl_client,
 		struct wl_resource *manager_resource, uint32_t id,
 		int32_t overlay_cursor, struct wl_resource *output_resource,
 		int32_t x, int32_t y, int32_t width, int32_t height) {
-	struct wlr_screencopy_manager_v1 *manager =
-		manager_from_resource(manager_resource);
+	struct wlr_screencopy_v1_client *client =
+		client_from_resource(manager_resource);
 	uint32_t version = wl_resource_get_version(manager_resource);
 	struct wlr_output *output = wlr_output_from_resource(output_resource);
 
@@ -269,7 +573,8 @@ static void manager_handle_capture_output_region(struct wl_client *client,
 		.width = width,
 		.height = height,
 	};
-	capture_output(client, manager, version, id, overlay_cursor, output, &box);
+	capture_output(wl_client, client, version, id, overlay_cursor, output,
+		&box);
 }
 
 static void manager_handle_destroy(struct wl_client *client,
@@ -284,20 +589,33 @@ static const struct zwlr_screencopy_manager_v1_interface manager_impl = {
 };
 
 void manager_handle_resource_destroy(struct wl_resource *resource) {
+	struct wlr_screencopy_v1_client *client = client_from_resource(resource);
+	client_unref(client);
 	wl_list_remove(wl_resource_get_link(resource));
 }
 
-static void manager_bind(struct wl_client *client, void *data, uint32_t version,
-		uint32_t id) {
+static void manager_bind(struct wl_client *wl_client, void *data,
+		uint32_t version, uint32_t id) {
 	struct wlr_screencopy_manager_v1 *manager = data;
 
-	struct wl_resource *resource = wl_resource_create(client,
+	struct wlr_screencopy_v1_client *client =
+		calloc(1, sizeof(struct wlr_screencopy_v1_client));
+	if (client == NULL) {
+		wl_client_post_no_memory(wl_client);
+		return;
+	}
+	client->ref = 1;
+	client->manager = manager;
+	wl_list_init(&client->damages);
+
+	struct wl_resource *resource = wl_resource_create(wl_client,
 		&zwlr_screencopy_manager_v1_interface, version, id);
 	if (resource == NULL) {
-		wl_client_post_no_memory(client);
+		free(client);
+		wl_client_post_no_memory(wl_client);
 		return;
 	}
-	wl_resource_set_implementation(resource, &manager_impl, manager,
+	wl_resource_set_implementation(resource, &manager_impl, client,
 		manager_handle_resource_destroy);
 
 	wl_list_insert(&manager->resources, wl_resource_get_link(resource));
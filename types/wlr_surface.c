@@ -11,6 +11,7 @@
 #include <wlr/util/log.h>
 #include <wlr/util/region.h>
 #include "util/signal.h"
+#include "util/trace.h"
 
 #define CALLBACK_VERSION 1
 #define SURFACE_VERSION 4
@@ -333,8 +334,12 @@ static void surface_update_input_region(struct wlr_surface *surface) {
 }
 
 static void surface_commit_pending(struct wlr_surface *surface) {
+	trace_surface_commit(wl_resource_get_client(surface->resource));
+
 	surface_state_finalize(surface, &surface->pending);
 
+	wlr_signal_emit_safe(&surface->events.precommit, surface);
+
 	if (surface->role && surface->role->precommit) {
 		surface->role->precommit(surface);
 	}
@@ -436,6 +441,10 @@ static void surface_commit(struct wl_client *client,
 		struct wl_resource *resource) {
 	struct wlr_surface *surface = wlr_surface_from_resource(resource);
 
+	trace_begin("wlr_surface_commit");
+
+	wlr_signal_emit_safe(&surface->events.client_commit, surface);
+
 	struct wlr_subsurface *subsurface = wlr_surface_is_subsurface(surface) ?
 		wlr_subsurface_from_wlr_surface(surface) : NULL;
 	if (subsurface != NULL) {
@@ -447,6 +456,8 @@ static void surface_commit(struct wl_client *client,
 	wl_list_for_each(subsurface, &surface->subsurfaces, parent_link) {
 		subsurface_parent_commit(subsurface, false);
 	}
+
+	trace_end();
 }
 
 static void surface_set_buffer_transform(struct wl_client *client,
@@ -614,6 +625,8 @@ struct wlr_surface *wlr_surface_create(struct wl_client *client,
 	surface_state_init(&surface->pending);
 	surface_state_init(&surface->previous);
 
+	wl_signal_init(&surface->events.precommit);
+	wl_signal_init(&surface->events.client_commit);
 	wl_signal_init(&surface->events.commit);
 	wl_signal_init(&surface->events.destroy);
 	wl_signal_init(&surface->events.new_subsurface);
@@ -0,0 +1,145 @@
+#include <string.h>
+#include "util/pixel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+void pixel_copy_rect(void *dst, size_t dst_stride, const void *src,
+		size_t src_stride, size_t row_bytes, size_t height, bool flip_y) {
+	if (!flip_y && dst_stride == row_bytes && src_stride == row_bytes) {
+		memcpy(dst, src, row_bytes * height);
+		return;
+	}
+
+	const uint8_t *s = src;
+	for (size_t i = 0; i < height; ++i) {
+		size_t dst_row = flip_y ? height - i - 1 : i;
+		memcpy((uint8_t *)dst + dst_row * dst_stride, s + i * src_stride,
+			row_bytes);
+	}
+}
+
+static inline uint32_t swap_rb(uint32_t p) {
+	return (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+}
+
+static void swap_rb_row_scalar(uint32_t *dst, const uint32_t *src, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		dst[i] = swap_rb(src[i]);
+	}
+}
+
+#if HAVE_X86
+
+#if defined(__SSE2__)
+static void swap_rb_row_sse2(uint32_t *dst, const uint32_t *src, size_t n) {
+	const __m128i ag_mask = _mm_set1_epi32(0xFF00FF00);
+	const __m128i b_mask = _mm_set1_epi32(0xFF);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128i p = _mm_loadu_si128((const __m128i *)&src[i]);
+		__m128i ag = _mm_and_si128(p, ag_mask);
+		__m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), b_mask);
+		__m128i b = _mm_slli_epi32(_mm_and_si128(p, b_mask), 16);
+		_mm_storeu_si128((__m128i *)&dst[i],
+			_mm_or_si128(ag, _mm_or_si128(r, b)));
+	}
+	swap_rb_row_scalar(&dst[i], &src[i], n - i);
+}
+#endif
+
+__attribute__((target("avx2")))
+static void swap_rb_row_avx2(uint32_t *dst, const uint32_t *src, size_t n) {
+	// Within each 32-bit pixel, swap bytes 0 and 2
+	const __m256i shuffle = _mm256_setr_epi8(
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i p = _mm256_loadu_si256((const __m256i *)&src[i]);
+		_mm256_storeu_si256((__m256i *)&dst[i],
+			_mm256_shuffle_epi8(p, shuffle));
+	}
+	swap_rb_row_scalar(&dst[i], &src[i], n - i);
+}
+
+#elif HAVE_NEON
+
+static void swap_rb_row_neon(uint32_t *dst, const uint32_t *src, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		uint8x16x4_t p = vld4q_u8((const uint8_t *)&src[i]);
+		uint8x16_t tmp = p.val[0];
+		p.val[0] = p.val[2];
+		p.val[2] = tmp;
+		vst4q_u8((uint8_t *)&dst[i], p);
+	}
+	swap_rb_row_scalar(&dst[i], &src[i], n - i);
+}
+
+#endif
+
+pixel_swap_rb_row_func_t pixel_get_swap_rb_row_impl(enum pixel_impl impl) {
+	switch (impl) {
+	case PIXEL_IMPL_SCALAR:
+		return swap_rb_row_scalar;
+	case PIXEL_IMPL_SSE2:
+#if HAVE_X86 && defined(__SSE2__)
+		return swap_rb_row_sse2;
+#else
+		return NULL;
+#endif
+	case PIXEL_IMPL_AVX2:
+#if HAVE_X86
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? swap_rb_row_avx2 : NULL;
+#else
+		return NULL;
+#endif
+	case PIXEL_IMPL_NEON:
+#if HAVE_NEON
+		return swap_rb_row_neon;
+#else
+		return NULL;
+#endif
+	}
+	return NULL;
+}
+
+static pixel_swap_rb_row_func_t select_swap_rb_row(void) {
+#if HAVE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return swap_rb_row_avx2;
+	}
+#if defined(__SSE2__)
+	return swap_rb_row_sse2;
+#endif
+#elif HAVE_NEON
+	return swap_rb_row_neon;
+#endif
+	return swap_rb_row_scalar;
+}
+
+void pixel_swap_rb_row(uint32_t *dst, const uint32_t *src, size_t n) {
+	static pixel_swap_rb_row_func_t impl = NULL;
+	if (impl == NULL) {
+		impl = select_swap_rb_row();
+	}
+	impl(dst, src, n);
+}
+
+void pixel_copy_rect_swap_rb(void *dst, size_t dst_stride, const void *src,
+		size_t src_stride, size_t width, size_t height, bool flip_y) {
+	const uint8_t *s = src;
+	for (size_t i = 0; i < height; ++i) {
+		size_t dst_row = flip_y ? height - i - 1 : i;
+		pixel_swap_rb_row((uint32_t *)((uint8_t *)dst + dst_row * dst_stride),
+			(const uint32_t *)(s + i * src_stride), width);
+	}
+}
@@ -4,7 +4,7 @@ static void handle_noop(struct wl_listener *listener, void *data) {
 	// Do nothing
 }
 
-void wlr_signal_emit_safe(struct wl_signal *signal, void *data) {
+void wlr_signal_emit_safe_slow(struct wl_signal *signal, void *data) {
 	struct wl_listener cursor;
 	struct wl_listener end;
 
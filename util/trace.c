@@ -0,0 +1,252 @@
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <wlr/config.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/util/log.h>
+#include "util/trace.h"
+
+static const char *const marker_paths[] = {
+	"/sys/kernel/tracing/trace_marker",
+	"/sys/kernel/debug/tracing/trace_marker",
+};
+
+static int marker_fd = -1;
+static pid_t marker_pid = 0;
+
+static bool open_marker(void) {
+	if (marker_fd >= 0) {
+		return true;
+	}
+
+	for (size_t i = 0; i < sizeof(marker_paths) / sizeof(marker_paths[0]); ++i) {
+		marker_fd = open(marker_paths[i], O_WRONLY | O_CLOEXEC);
+		if (marker_fd >= 0) {
+			marker_pid = getpid();
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool write_marker(const char *buf, int len) {
+	if (len < 0 || marker_fd < 0) {
+		return false;
+	}
+	return write(marker_fd, buf, len) >= 0;
+}
+
+#if WLR_HAS_TRACING
+
+int trace_state = -1;
+
+bool trace_init(void) {
+	const char *env = getenv("WLR_TRACE");
+	trace_state = env != NULL && strcmp(env, "1") == 0;
+	if (trace_state && !open_marker()) {
+		wlr_log(WLR_ERROR, "Failed to open ftrace marker, tracing disabled");
+		trace_state = 0;
+	}
+	return trace_state;
+}
+
+void trace_write_begin(const char *name) {
+	char buf[256];
+	int len = snprintf(buf, sizeof(buf), "B|%d|%s", marker_pid, name);
+	write_marker(buf, len < (int)sizeof(buf) ? len : (int)sizeof(buf) - 1);
+}
+
+void trace_write_end(void) {
+	char buf[32];
+	int len = snprintf(buf, sizeof(buf), "E|%d", marker_pid);
+	write_marker(buf, len);
+}
+
+void trace_write_counter(const char *name, const char *instance,
+		int64_t value) {
+	char buf[256];
+	int len = snprintf(buf, sizeof(buf), "C|%d|%s%s%s|%"PRId64, marker_pid,
+		name, instance != NULL ? ":" : "", instance != NULL ? instance : "",
+		value);
+	write_marker(buf, len < (int)sizeof(buf) ? len : (int)sizeof(buf) - 1);
+}
+
+#endif
+
+// Drop the traced event if nothing has been presented after this delay
+#define INPUT_LATENCY_TIMEOUT_USEC 1000000
+
+enum input_latency_stage {
+	INPUT_LATENCY_IDLE,
+	INPUT_LATENCY_INPUT,
+	INPUT_LATENCY_NOTIFIED,
+	INPUT_LATENCY_CLIENT_COMMITTED,
+	INPUT_LATENCY_OUTPUT_COMMITTED,
+};
+
+static struct {
+	bool initialized;
+	bool enabled;
+
+	uint32_t next_id;
+
+	// The input event being followed
+	enum input_latency_stage stage;
+	uint32_t id;
+	struct wl_client *client;
+	struct wlr_output *output;
+	uint64_t input_usec, notify_usec, client_commit_usec, output_commit_usec;
+} input_latency = {0};
+
+static bool input_latency_enabled(void) {
+	if (input_latency.initialized) {
+		return input_latency.enabled;
+	}
+	input_latency.initialized = true;
+
+	const char *env = getenv("WLR_TRACE_INPUT_LATENCY");
+	if (env == NULL || strcmp(env, "1") != 0) {
+		return false;
+	}
+	input_latency.enabled = true;
+
+	if (!open_marker()) {
+		wlr_log(WLR_INFO, "Failed to open ftrace marker, input latency "
+			"traces will be written to the log");
+	}
+
+	return true;
+}
+
+static uint64_t timespec_to_usec(const struct timespec *a) {
+	return (uint64_t)a->tv_sec * 1000000 + a->tv_nsec / 1000;
+}
+
+static uint64_t get_current_time_usec(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return timespec_to_usec(&now);
+}
+
+static int64_t usec_delta(uint64_t from, uint64_t to) {
+	return from != 0 ? (int64_t)(to - from) : -1;
+}
+
+static void input_latency_report(uint64_t present_usec) {
+	char buf[512];
+	int len = snprintf(buf, sizeof(buf), "wlr_input_latency: id=%"PRIu32
+		" output=%s total_us=%"PRId64" input_to_notify_us=%"PRId64
+		" notify_to_client_commit_us=%"PRId64
+		" client_commit_to_output_commit_us=%"PRId64
+		" output_commit_to_present_us=%"PRId64"\n",
+		input_latency.id, input_latency.output->name,
+		usec_delta(input_latency.input_usec, present_usec),
+		usec_delta(input_latency.input_usec, input_latency.notify_usec),
+		usec_delta(input_latency.notify_usec, input_latency.client_commit_usec),
+		usec_delta(input_latency.client_commit_usec != 0 ?
+			input_latency.client_commit_usec : input_latency.notify_usec,
+			input_latency.output_commit_usec),
+		usec_delta(input_latency.output_commit_usec, present_usec));
+	if (len < 0) {
+		return;
+	}
+	if ((size_t)len >= sizeof(buf)) {
+		len = sizeof(buf) - 1;
+	}
+
+	if (!write_marker(buf, len)) {
+		buf[len - 1] = '\0';
+		wlr_log(WLR_INFO, "%s", buf);
+	}
+}
+
+void trace_input_event(uint64_t time_usec) {
+	if (!input_latency_enabled()) {
+		return;
+	}
+
+	if (input_latency.stage != INPUT_LATENCY_IDLE) {
+		uint64_t now = get_current_time_usec();
+		if (now - input_latency.input_usec < INPUT_LATENCY_TIMEOUT_USEC) {
+			return;
+		}
+		wlr_log(WLR_DEBUG, "Dropping input latency trace %"PRIu32
+			": nothing presented", input_latency.id);
+	}
+
+	input_latency.stage = INPUT_LATENCY_INPUT;
+	input_latency.id = input_latency.next_id++;
+	input_latency.client = NULL;
+	input_latency.output = NULL;
+	input_latency.input_usec = time_usec;
+	input_latency.notify_usec = 0;
+	input_latency.client_commit_usec = 0;
+	input_latency.output_commit_usec = 0;
+}
+
+void trace_seat_notify(struct wl_client *client) {
+	if (!input_latency.enabled ||
+			input_latency.stage != INPUT_LATENCY_INPUT) {
+		return;
+	}
+
+	input_latency.stage = INPUT_LATENCY_NOTIFIED;
+	input_latency.client = client;
+	input_latency.notify_usec = get_current_time_usec();
+}
+
+void trace_surface_commit(struct wl_client *client) {
+	if (!input_latency.enabled ||
+			input_latency.stage != INPUT_LATENCY_NOTIFIED ||
+			input_latency.client == NULL || input_latency.client != client) {
+		return;
+	}
+
+	input_latency.stage = INPUT_LATENCY_CLIENT_COMMITTED;
+	input_latency.client_commit_usec = get_current_time_usec();
+}
+
+void trace_output_commit(struct wlr_output *output) {
+	if (!input_latency.enabled) {
+		return;
+	}
+
+	// If the event has been sent to a client, wait for it to respond.
+	// Otherwise the event only affects the compositor (e.g. cursor motion).
+	bool ready = input_latency.stage == INPUT_LATENCY_CLIENT_COMMITTED ||
+		(input_latency.stage == INPUT_LATENCY_NOTIFIED &&
+		input_latency.client == NULL);
+	if (!ready) {
+		return;
+	}
+
+	input_latency.stage = INPUT_LATENCY_OUTPUT_COMMITTED;
+	input_latency.output = output;
+	input_latency.output_commit_usec = get_current_time_usec();
+}
+
+void trace_output_present(struct wlr_output *output,
+		const struct timespec *when) {
+	if (!input_latency.enabled ||
+			input_latency.stage != INPUT_LATENCY_OUTPUT_COMMITTED) {
+		return;
+	}
+
+	if (input_latency.output != output) {
+		// The traced output may be gone, in which case the trace will time
+		// out
+		return;
+	}
+
+	uint64_t present_usec = when != NULL ?
+		timespec_to_usec(when) : get_current_time_usec();
+	input_latency_report(present_usec);
+	input_latency.stage = INPUT_LATENCY_IDLE;
+}
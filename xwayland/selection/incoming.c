@@ -8,6 +8,7 @@
 #include <wlr/types/wlr_primary_selection.h>
 #include <wlr/util/log.h>
 #include <xcb/xfixes.h>
+#include "util/trace.h"
 #include "xwayland/selection.h"
 #include "xwayland/xwm.h"
 
@@ -85,8 +86,10 @@ void xwm_get_incr_chunk(struct wlr_xwm_selection_transfer *transfer) {
 		0x1fffffff // length
 		);
 
+	trace_begin("wlr_xwm_round_trip");
 	xcb_get_property_reply_t *reply =
 		xcb_get_property_reply(xwm->xcb_conn, cookie, NULL);
+	trace_end();
 	if (reply == NULL) {
 		wlr_log(WLR_ERROR, "cannot get selection property");
 		return;
@@ -116,8 +119,10 @@ static void xwm_selection_get_data(struct wlr_xwm_selection *selection) {
 		0x1fffffff // length
 		);
 
+	trace_begin("wlr_xwm_round_trip");
 	xcb_get_property_reply_t *reply =
 		xcb_get_property_reply(xwm->xcb_conn, cookie, NULL);
+	trace_end();
 	if (reply == NULL) {
 		wlr_log(WLR_ERROR, "Cannot get selection property");
 		return;
@@ -267,8 +272,10 @@ static bool source_get_targets(struct wlr_xwm_selection *selection,
 		4096 // length
 		);
 
+	trace_begin("wlr_xwm_round_trip");
 	xcb_get_property_reply_t *reply =
 		xcb_get_property_reply(xwm->xcb_conn, cookie, NULL);
+	trace_end();
 	if (reply == NULL) {
 		return false;
 	}
@@ -290,8 +297,10 @@ static bool source_get_targets(struct wlr_xwm_selection *selection,
 				value[i] != xwm->atoms[TIMESTAMP]) {
 			xcb_get_atom_name_cookie_t name_cookie =
 				xcb_get_atom_name(xwm->xcb_conn, value[i]);
+			trace_begin("wlr_xwm_round_trip");
 			xcb_get_atom_name_reply_t *name_reply =
 				xcb_get_atom_name_reply(xwm->xcb_conn, name_cookie, NULL);
+			trace_end();
 			if (name_reply == NULL) {
 				continue;
 			}
@@ -13,7 +13,9 @@
 #include <xcb/composite.h>
 #include <xcb/render.h>
 #include <xcb/xfixes.h>
+#include "util/pixel.h"
 #include "util/signal.h"
+#include "util/trace.h"
 #include "xwayland/xwm.h"
 
 const char *atom_map[ATOM_LAST] = {
@@ -163,8 +165,10 @@ static struct wlr_xwayland_surface *xwayland_surface_create(
 	wl_signal_init(&surface->events.set_override_redirect);
 	wl_signal_init(&surface->events.ping_timeout);
 
+	trace_begin("wlr_xwm_round_trip");
 	xcb_get_geometry_reply_t *geometry_reply =
 		xcb_get_geometry_reply(xwm->xcb_conn, geometry_cookie, NULL);
+	trace_end();
 	if (geometry_reply != NULL) {
 		surface->has_alpha = geometry_reply->depth == 32;
 	}
@@ -672,8 +676,10 @@ static void read_surface_net_wm_state(struct wlr_xwm *xwm,
 char *xwm_get_atom_name(struct wlr_xwm *xwm, xcb_atom_t atom) {
 	xcb_get_atom_name_cookie_t name_cookie =
 		xcb_get_atom_name(xwm->xcb_conn, atom);
+	trace_begin("wlr_xwm_round_trip");
 	xcb_get_atom_name_reply_t *name_reply =
 		xcb_get_atom_name_reply(xwm->xcb_conn, name_cookie, NULL);
+	trace_end();
 	if (name_reply == NULL) {
 		return NULL;
 	}
@@ -688,8 +694,10 @@ static void read_surface_property(struct wlr_xwm *xwm,
 		struct wlr_xwayland_surface *xsurface, xcb_atom_t property) {
 	xcb_get_property_cookie_t cookie = xcb_get_property(xwm->xcb_conn, 0,
 		xsurface->window_id, property, XCB_ATOM_ANY, 0, 2048);
+	trace_begin("wlr_xwm_round_trip");
 	xcb_get_property_reply_t *reply = xcb_get_property_reply(xwm->xcb_conn,
 		cookie, NULL);
+	trace_end();
 	if (reply == NULL) {
 		return;
 	}
@@ -1649,6 +1657,21 @@ void xwm_set_cursor(struct wlr_xwm *xwm, const uint8_t *pixels, uint32_t stride,
 		wlr_log(WLR_ERROR, "Cannot set xwm cursor: no render format available");
 		return;
 	}
+
+	// Z-pixmap rows of 32-bit pixels are tightly packed
+	uint32_t pack_stride = width * 4;
+	uint8_t *packed = NULL;
+	if (stride != pack_stride) {
+		packed = malloc(pack_stride * height);
+		if (packed == NULL) {
+			wlr_log(WLR_ERROR, "Allocation failed");
+			return;
+		}
+		pixel_copy_rect(packed, pack_stride, pixels, stride, pack_stride,
+			height, false);
+		pixels = packed;
+	}
+
 	if (xwm->cursor) {
 		xcb_free_cursor(xwm->xcb_conn, xwm->cursor);
 	}
@@ -1667,9 +1690,10 @@ void xwm_set_cursor(struct wlr_xwm *xwm, const uint8_t *pixels, uint32_t stride,
 	xcb_create_gc(xwm->xcb_conn, gc, pix, 0, NULL);
 
 	xcb_put_image(xwm->xcb_conn, XCB_IMAGE_FORMAT_Z_PIXMAP, pix, gc,
-		width, height, 0, 0, 0, depth, stride * height * sizeof(uint8_t),
+		width, height, 0, 0, 0, depth, pack_stride * height * sizeof(uint8_t),
 		pixels);
 	xcb_free_gc(xwm->xcb_conn, gc);
+	free(packed);
 
 	xwm->cursor = xcb_generate_id(xwm->xcb_conn);
 	xcb_render_create_cursor(xwm->xcb_conn, xwm->cursor, pic, hotspot_x,